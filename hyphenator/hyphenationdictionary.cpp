@@ -0,0 +1,288 @@
+#include "hyphenationdictionary.h"
+
+#include <QDebug>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+
+namespace Hyphenation
+{
+//! Сигнатура файла словаря
+static const char _magic[4] = {'H', 'Y', 'P', 'D'};
+//! Версия формата
+static const quint32 _version = 1;
+//! Пустая ячейка хэш-индекса
+static const quint32 _empty_bucket = 0xFFFFFFFF;
+
+//! Заголовок файла. Смещения разделов в байтах от начала файла, выровнены на 4 байта
+struct HyphenationDictionary::FileHeader
+{
+    char magic[4];
+    quint32 version;
+    quint32 word_count;
+    //! Размер хэш-индекса (степень двойки)
+    quint32 bucket_count;
+    quint32 entries_offset;
+    quint32 index_offset;
+    quint32 breaks_offset;
+    quint32 strings_offset;
+    quint32 file_size;
+};
+
+//! Запись о слове
+struct HyphenationDictionary::FileEntry
+{
+    //! Смещение текста в разделе строк (в символах)
+    quint32 text_offset;
+    //! Смещение мест переносов в разделе переносов (в элементах)
+    quint32 breaks_offset;
+    quint16 text_length;
+    quint16 break_count;
+};
+
+static quint32 align4(quint32 value)
+{
+    return (value + 3) & ~quint32(3);
+}
+
+HyphenationDictionary::HyphenationDictionary()
+{
+}
+
+HyphenationDictionary::~HyphenationDictionary()
+{
+    close();
+}
+
+bool HyphenationDictionary::open(const QString& file_name)
+{
+    close();
+
+    _file.setFileName(file_name);
+    if (!_file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = _file.size();
+    if (size < static_cast<qint64>(sizeof(FileHeader))) {
+        qDebug() << "HyphenationDictionary: invalid file" << file_name;
+        close();
+        return false;
+    }
+
+    _data = _file.map(0, size);
+    if (_data == nullptr) {
+        close();
+        return false;
+    }
+
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(_data);
+    const quint64 word_count = header->word_count;
+    const quint64 bucket_count = header->bucket_count;
+    bool valid = memcmp(header->magic, _magic, sizeof(_magic)) == 0 && header->version == _version && header->file_size == size
+                 && (bucket_count & (bucket_count - 1)) == 0 && bucket_count > word_count
+                 && header->entries_offset + word_count * sizeof(FileEntry) <= header->index_offset
+                 && header->index_offset + bucket_count * sizeof(quint32) <= header->breaks_offset
+                 && header->breaks_offset <= header->strings_offset && header->strings_offset <= static_cast<quint64>(size)
+                 && header->entries_offset % 4 == 0 && header->index_offset % 4 == 0 && header->breaks_offset % 4 == 0
+                 && header->strings_offset % 4 == 0;
+
+    const FileEntry* entries = reinterpret_cast<const FileEntry*>(_data + header->entries_offset);
+    const quint32* index = reinterpret_cast<const quint32*>(_data + header->index_offset);
+
+    // ссылки записей и индекса не должны выходить за пределы разделов, иначе поиск по поврежденному файлу обратится к
+    // чужой памяти
+    if (valid) {
+        const quint64 break_count = (header->strings_offset - header->breaks_offset) / sizeof(quint16);
+        const quint64 string_size = (size - header->strings_offset) / sizeof(QChar);
+        for (quint64 i = 0; i < word_count && valid; i++) {
+            const FileEntry& entry = entries[i];
+            valid = static_cast<quint64>(entry.text_offset) + entry.text_length <= string_size
+                    && static_cast<quint64>(entry.breaks_offset) + entry.break_count <= break_count;
+        }
+        for (quint64 i = 0; i < bucket_count && valid; i++) {
+            valid = index[i] == _empty_bucket || index[i] < word_count;
+        }
+    }
+
+    if (!valid) {
+        qDebug() << "HyphenationDictionary: invalid file" << file_name;
+        close();
+        return false;
+    }
+
+    _header = header;
+    _entries = entries;
+    _index = index;
+    _breaks = reinterpret_cast<const quint16*>(_data + header->breaks_offset);
+    _strings = reinterpret_cast<const QChar*>(_data + header->strings_offset);
+    return true;
+}
+
+void HyphenationDictionary::close()
+{
+    if (_data != nullptr)
+        _file.unmap(const_cast<uchar*>(_data));
+    _file.close();
+
+    _data = nullptr;
+    _header = nullptr;
+    _entries = nullptr;
+    _index = nullptr;
+    _breaks = nullptr;
+    _strings = nullptr;
+}
+
+bool HyphenationDictionary::isOpen() const
+{
+    return _header != nullptr;
+}
+
+QString HyphenationDictionary::fileName() const
+{
+    return _file.fileName();
+}
+
+int HyphenationDictionary::count() const
+{
+    return _header == nullptr ? 0 : static_cast<int>(_header->word_count);
+}
+
+bool HyphenationDictionary::find(const QString& word, HyphenBreaks& breaks) const
+{
+    if (_header == nullptr || _header->word_count == 0 || word.isEmpty())
+        return false;
+
+    const quint32 mask = _header->bucket_count - 1;
+    quint32 bucket = wordHash(word.constData(), word.size()) & mask;
+    // в поврежденном файле может не быть пустых ячеек, поэтому не более одного прохода по индексу
+    for (quint32 probe = 0; probe < _header->bucket_count; probe++, bucket = (bucket + 1) & mask) {
+        const quint32 entry_index = _index[bucket];
+        if (entry_index == _empty_bucket)
+            return false;
+
+        const FileEntry& entry = _entries[entry_index];
+        if (entry.text_length != word.size() || memcmp(entryText(entry), word.constData(), word.size() * sizeof(QChar)) != 0)
+            continue;
+
+        for (int i = 0; i < entry.break_count; i++) {
+            breaks.append(_breaks[entry.breaks_offset + i]);
+        }
+        return true;
+    }
+    return false;
+}
+
+HyphenatedWord HyphenationDictionary::word(int index) const
+{
+    Q_ASSERT(index >= 0 && index < count());
+    const FileEntry& entry = _entries[index];
+
+    HyphenBreaks breaks;
+    for (int i = 0; i < entry.break_count; i++) {
+        breaks.append(_breaks[entry.breaks_offset + i]);
+    }
+    return HyphenatedWord(QString(entryText(entry), entry.text_length), breaks);
+}
+
+QByteArray HyphenationDictionary::build(const QVector<HyphenatedWord>& words)
+{
+    // слова сортируются, чтобы таблица была упорядочена
+    QVector<const HyphenatedWord*> sorted;
+    sorted.reserve(words.count());
+    for (auto& w : words) {
+        if (!w.text().isEmpty() && w.text().size() <= 0xFFFF)
+            sorted << &w;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const HyphenatedWord* w1, const HyphenatedWord* w2) { return w1->text() < w2->text(); });
+    sorted.erase(std::unique(sorted.begin(), sorted.end(), [](const HyphenatedWord* w1, const HyphenatedWord* w2) { return w1->text() == w2->text(); }),
+                 sorted.end());
+
+    quint32 bucket_count = 1;
+    while (bucket_count < static_cast<quint32>(sorted.count()) * 2) {
+        bucket_count <<= 1;
+    }
+
+    QVector<FileEntry> entries;
+    entries.reserve(sorted.count());
+    QVector<quint16> breaks;
+    QString strings;
+    for (auto w : qAsConst(sorted)) {
+        const HyphenBreaks word_breaks = w->breaks();
+        FileEntry entry;
+        entry.text_offset = static_cast<quint32>(strings.size());
+        entry.breaks_offset = static_cast<quint32>(breaks.count());
+        entry.text_length = static_cast<quint16>(w->text().size());
+        entry.break_count = static_cast<quint16>(word_breaks.size());
+        for (int b : word_breaks) {
+            breaks << static_cast<quint16>(b);
+        }
+        strings += w->text();
+        entries << entry;
+    }
+
+    QVector<quint32> index(static_cast<int>(bucket_count), _empty_bucket);
+    const quint32 mask = bucket_count - 1;
+    for (int i = 0; i < sorted.count(); i++) {
+        quint32 bucket = wordHash(sorted.at(i)->text().constData(), sorted.at(i)->text().size()) & mask;
+        while (index.at(static_cast<int>(bucket)) != _empty_bucket) {
+            bucket = (bucket + 1) & mask;
+        }
+        index[static_cast<int>(bucket)] = static_cast<quint32>(i);
+    }
+
+    FileHeader header;
+    memcpy(header.magic, _magic, sizeof(_magic));
+    header.version = _version;
+    header.word_count = static_cast<quint32>(entries.count());
+    header.bucket_count = bucket_count;
+    header.entries_offset = align4(sizeof(FileHeader));
+    header.index_offset = align4(header.entries_offset + entries.count() * sizeof(FileEntry));
+    header.breaks_offset = align4(header.index_offset + bucket_count * sizeof(quint32));
+    header.strings_offset = align4(header.breaks_offset + breaks.count() * sizeof(quint16));
+    header.file_size = header.strings_offset + strings.size() * sizeof(QChar);
+
+    QByteArray data(static_cast<int>(header.file_size), 0);
+    char* p = data.data();
+    memcpy(p, &header, sizeof(FileHeader));
+    if (!entries.isEmpty())
+        memcpy(p + header.entries_offset, entries.constData(), entries.count() * sizeof(FileEntry));
+    memcpy(p + header.index_offset, index.constData(), bucket_count * sizeof(quint32));
+    if (!breaks.isEmpty())
+        memcpy(p + header.breaks_offset, breaks.constData(), breaks.count() * sizeof(quint16));
+    if (!strings.isEmpty())
+        memcpy(p + header.strings_offset, strings.constData(), strings.size() * sizeof(QChar));
+
+    return data;
+}
+
+bool HyphenationDictionary::save(const QString& file_name, const QVector<HyphenatedWord>& words)
+{
+    // QSaveFile пишет во временный файл и подменяет исходный, поэтому уже отображенный в память словарь не портится
+    QSaveFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QByteArray data = build(words);
+    if (file.write(data) != data.size()) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+quint32 HyphenationDictionary::wordHash(const QChar* text, int size)
+{
+    // FNV-1a
+    quint32 hash = 2166136261u;
+    for (int i = 0; i < size; i++) {
+        hash ^= text[i].unicode();
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+const QChar* HyphenationDictionary::entryText(const FileEntry& entry) const
+{
+    return _strings + entry.text_offset;
+}
+} // namespace Hyphenation
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "hyphenator.h"
+
+#include <QFile>
+
+namespace Hyphenation
+{
+//! Словарь переносов в файле, который отображается в память и читается без копирования
+//! Формат файла: заголовок, отсортированная таблица слов, места переносов и хэш-индекс (открытая адресация).
+//! Строки хранятся в UTF-16, порядок байт - как у платформы, на которой создан файл
+//! Поиск потокобезопасен. Открытие и закрытие не должны пересекаться с поиском
+class HYPHENATOR_DLL_API HyphenationDictionary
+{
+public:
+    HyphenationDictionary();
+    ~HyphenationDictionary();
+
+    //! Открыть файл словаря. Файл отображается в память
+    bool open(const QString& file_name);
+    //! Закрыть файл словаря
+    void close();
+    //! Открыт ли словарь
+    bool isOpen() const;
+    //! Имя файла словаря
+    QString fileName() const;
+
+    //! Количество слов
+    int count() const;
+    //! Найти слово (после simplified). В breaks добавляются места переносов
+    bool find(const QString& word, HyphenBreaks& breaks) const;
+    //! Слово по индексу в отсортированной таблице
+    HyphenatedWord word(int index) const;
+
+    //! Сформировать содержимое файла словаря. Слова с пустым текстом и повторы игнорируются
+    static QByteArray build(const QVector<HyphenatedWord>& words);
+    //! Сохранить слова в файл словаря
+    static bool save(const QString& file_name, const QVector<HyphenatedWord>& words);
+
+private:
+    Q_DISABLE_COPY(HyphenationDictionary)
+
+    struct FileHeader;
+    struct FileEntry;
+
+    //! Хэш слова. Не зависит от версии Qt и seed qHash, т.к. сохраняется в файле
+    static quint32 wordHash(const QChar* text, int size);
+    //! Строка слова по записи
+    const QChar* entryText(const FileEntry& entry) const;
+
+    QFile _file;
+    const uchar* _data = nullptr;
+
+    // Разделы файла
+    const FileHeader* _header = nullptr;
+    const FileEntry* _entries = nullptr;
+    const quint32* _index = nullptr;
+    const quint16* _breaks = nullptr;
+    const QChar* _strings = nullptr;
+};
+} // namespace Hyphenation
@@ -1,12 +1,66 @@
 #include "hyphenationhash.h"
+#include "hyphenationdictionary.h"
+#include "hyphenationlanguages.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QSet>
 
 namespace Hyphenation
 {
-HyphenationHash::HyphenationHash(Hyphenator* hyphenator)
+//! Сегмент хэша
+struct HyphenationHash::Shard
+{
+    //! Ячейка хэша
+    struct Slot
+    {
+        HyphenatedWord word;
+        //! День последнего использования (юлианский)
+        qint32 day = 0;
+        //! Бит обращения для CLOCK
+        bool referenced = false;
+        //! Ячейка занята
+        bool used = false;
+    };
+
+    mutable QMutex mutex;
+    //! Нормализованное слово - индекс ячейки
+    QHash<QString, int> index;
+    QVector<Slot> slots;
+    //! Свободные ячейки
+    QVector<int> free_slots;
+    //! Стрелка CLOCK
+    int hand = 0;
+    //! Занимаемая память
+    qint64 cost = 0;
+
+    //! Приблизительный размер слова в памяти: ячейка, узел индекса, текст и места переносов вне QVarLengthArray
+    static qint64 wordCost(const HyphenatedWord& word)
+    {
+        const int breaks = word.breaks().size();
+        qint64 breaks_cost = breaks > 16 ? breaks * static_cast<qint64>(sizeof(int)) : 0;
+        return static_cast<qint64>(sizeof(Slot)) + 32 + word.text().size() * static_cast<qint64>(sizeof(QChar)) + breaks_cost;
+    }
+
+    //! Освободить ячейку
+    void remove(int slot)
+    {
+        Slot& s = slots[slot];
+        Q_ASSERT(s.used);
+        cost -= wordCost(s.word);
+        index.remove(s.word.text());
+        s = Slot();
+        free_slots << slot;
+    }
+};
+
+HyphenationHash::HyphenationHash(Hyphenator* hyphenator, qint64 max_cost)
+    : _max_cost(max_cost)
 {
     _hyphenator = hyphenator;
+    for (int i = 0; i < SHARD_COUNT; i++) {
+        _shards << std::make_shared<Shard>();
+    }
 }
 
 HyphenationHash::~HyphenationHash()
@@ -15,28 +69,258 @@ HyphenationHash::~HyphenationHash()
 
 HyphenatedWord HyphenationHash::findWord(const QString& text)
 {
+    // ключ всегда нормализованное слово, т.к. HyphenatedWord хранит текст после simplified
     QString t = text.simplified();
     if (t.isEmpty()) {
         return HyphenatedWord();
     }
 
-    HASH_KEY_TYPE hashValue = qHash(text);
+    Shard* s = shard(t);
+    const qint32 day = currentDay();
+    {
+        QMutexLocker lock(&s->mutex);
+        auto it = s->index.constFind(t);
+        if (it != s->index.constEnd()) {
+            Shard::Slot& slot = s->slots[it.value()];
+            slot.referenced = true;
+            slot.day = day;
+            return slot.word;
+        }
+    }
+
+    // Словарь читается без копирования данных, поэтому найденные в нем слова в хэш не добавляются
+    auto dictionary = this->dictionary();
+    if (dictionary != nullptr) {
+        HyphenBreaks breaks;
+        if (dictionary->find(t, breaks))
+            return HyphenatedWord(t, breaks);
+    }
+
+    // Ничего не найдено. Разбиваем вне блокировки, чтобы не задерживать другие потоки
+    HyphenatedWord newWord(t);
+    _hyphenator->hyphenate(newWord);
+    return insert(newWord, day);
+}
+
+qint64 HyphenationHash::maxCost() const
+{
+    return _max_cost.load(std::memory_order_relaxed);
+}
+
+void HyphenationHash::setMaxCost(qint64 max_cost)
+{
+    _max_cost.store(max_cost, std::memory_order_relaxed);
+    for (auto& s : qAsConst(_shards)) {
+        QMutexLocker lock(&s->mutex);
+        evict(s.get());
+    }
+}
+
+qint64 HyphenationHash::totalCost() const
+{
+    qint64 res = 0;
+    for (auto& s : qAsConst(_shards)) {
+        QMutexLocker lock(&s->mutex);
+        res += s->cost;
+    }
+    return res;
+}
+
+int HyphenationHash::count() const
+{
+    int res = 0;
+    for (auto& s : qAsConst(_shards)) {
+        QMutexLocker lock(&s->mutex);
+        res += s->index.count();
+    }
+    return res;
+}
+
+void HyphenationHash::clear()
+{
+    for (auto& s : qAsConst(_shards)) {
+        QMutexLocker lock(&s->mutex);
+        s->index.clear();
+        s->slots.clear();
+        s->free_slots.clear();
+        s->hand = 0;
+        s->cost = 0;
+    }
+}
+
+void HyphenationHash::insertWords(const QVector<HyphenatedWord>& words)
+{
+    auto dictionary = this->dictionary();
+    const qint32 day = currentDay();
+    HyphenBreaks breaks;
+    for (auto& word : words) {
+        if (word.text().isEmpty() || !word.isHyphenated())
+            continue;
+
+        if (dictionary != nullptr && dictionary->find(word.text(), breaks)) {
+            breaks.clear();
+            continue;
+        }
+
+        insert(word, day);
+    }
+}
+
+void HyphenationHash::setDictionary(const std::shared_ptr<HyphenationDictionary>& dictionary)
+{
+    QMutexLocker lock(&_dictionary_mutex);
+    _dictionary = dictionary;
+}
+
+std::shared_ptr<HyphenationDictionary> HyphenationHash::dictionary() const
+{
+    QMutexLocker lock(&_dictionary_mutex);
+    return _dictionary;
+}
+
+bool HyphenationHash::openDictionary(const QString& file_name)
+{
+    auto dictionary = std::make_shared<HyphenationDictionary>();
+    if (!dictionary->open(file_name))
+        return false;
+
+    setDictionary(dictionary);
+    return true;
+}
+
+bool HyphenationHash::compactDictionary(const QString& file_name)
+{
+    QVector<HyphenatedWord> words;
+    QSet<QString> added;
+    for (auto& s : qAsConst(_shards)) {
+        QMutexLocker lock(&s->mutex);
+        for (auto& slot : qAsConst(s->slots)) {
+            if (!slot.used)
+                continue;
+
+            words << slot.word;
+            added << slot.word.text();
+        }
+    }
+
+    auto dictionary = this->dictionary();
+    if (dictionary != nullptr) {
+        for (int i = 0; i < dictionary->count(); i++) {
+            HyphenatedWord word = dictionary->word(i);
+            if (!added.contains(word.text()))
+                words << word;
+        }
+    }
+
+    // старый словарь остается отображенным в память, пока его используют другие потоки
+    if (!HyphenationDictionary::save(file_name, words))
+        return false;
+
+    if (!openDictionary(file_name))
+        return false;
+
+    // слова перенесены в словарь
+    clear();
+    return true;
+}
+
+HyphenationHash::Shard* HyphenationHash::shard(const QString& key) const
+{
+    return _shards.at(static_cast<int>(qHash(key) % SHARD_COUNT)).get();
+}
+
+HyphenatedWord HyphenationHash::insert(const HyphenatedWord& word, qint32 day)
+{
+    Shard* s = shard(word.text());
+    QMutexLocker lock(&s->mutex);
+
+    // пока слово разбивалось, его мог добавить другой поток
+    auto it = s->index.constFind(word.text());
+    if (it != s->index.constEnd()) {
+        Shard::Slot& slot = s->slots[it.value()];
+        slot.referenced = true;
+        slot.day = qMax(slot.day, day);
+        return slot.word;
+    }
+
+    int slot_index;
+    if (s->free_slots.isEmpty()) {
+        slot_index = s->slots.count();
+        s->slots.append(Shard::Slot());
+    } else {
+        slot_index = s->free_slots.takeLast();
+    }
+
+    Shard::Slot& slot = s->slots[slot_index];
+    slot.word = word;
+    slot.day = day;
+    // новое слово вытесняется при первом проходе стрелки, если к нему не было повторных обращений
+    slot.referenced = false;
+    slot.used = true;
+    s->index.insert(word.text(), slot_index);
+    s->cost += Shard::wordCost(word);
+
+    evict(s);
+    return word;
+}
+
+void HyphenationHash::evict(Shard* shard)
+{
+    const qint64 budget = _max_cost.load(std::memory_order_relaxed) / SHARD_COUNT;
+
+    // за два оборота стрелки сбрасываются все биты обращения, поэтому цикл конечен
+    while (shard->cost > budget && !shard->index.isEmpty()) {
+        if (shard->hand >= shard->slots.count())
+            shard->hand = 0;
 
-    auto hashed = _hash.values(hashValue);
-    // Проверяем что выдал запрос по хэшу
-    for (auto i = hashed.begin(); i != hashed.end(); ++i) {
-        if (QString::compare(i->word().text(), t, Qt::CaseSensitive) == 0) {
-            i->setCurrentDate();
-            return i->word();
+        Shard::Slot& slot = shard->slots[shard->hand];
+        if (slot.used) {
+            if (slot.referenced)
+                slot.referenced = false;
+            else
+                shard->remove(shard->hand);
         }
+        shard->hand++;
     }
+}
+
+HyphenationHash::StreamHash HyphenationHash::toStreamHash() const
+{
+    StreamHash res;
+    for (auto& s : qAsConst(_shards)) {
+        QMutexLocker lock(&s->mutex);
+        for (auto& slot : qAsConst(s->slots)) {
+            if (!slot.used)
+                continue;
 
-    // Ничего не найдено. Создаем новое слово в хэше
-    HyphenatedWord newWord(text);
-    HashData newData(newWord);
-    _hyphenator->hyphenate(newData.word());
-    _hash.insert(hashValue, newData);
-    return newData.word();
+            res.insert(qHash(slot.word.text()), HashData(slot.word, QDate::fromJulianDay(slot.day)));
+        }
+    }
+    return res;
+}
+
+qint32 HyphenationHash::currentDay()
+{
+    // QElapsedTimer монотонный и дешевый, а QDate::currentDate требует перевода в локальное время
+    static const QElapsedTimer timer = []() {
+        QElapsedTimer t;
+        t.start();
+        return t;
+    }();
+    static std::atomic<qint64> next_check(0);
+    static std::atomic<qint32> day(0);
+    static QMutex mutex;
+
+    const qint64 elapsed = timer.elapsed();
+    if (elapsed < next_check.load(std::memory_order_acquire))
+        return day.load(std::memory_order_relaxed);
+
+    QMutexLocker lock(&mutex);
+    if (elapsed >= next_check.load(std::memory_order_relaxed)) {
+        day.store(static_cast<qint32>(QDate::currentDate().toJulianDay()), std::memory_order_relaxed);
+        next_check.store(elapsed + 60 * 1000, std::memory_order_release);
+    }
+    return day.load(std::memory_order_relaxed);
 }
 
 bool HyphenationHash::saveToFile(QFile& file)
@@ -66,12 +350,12 @@ bool HyphenationHash::loadFromFile(QFile& file)
 
 void HyphenationHash::clearOldHash(const QDate& date)
 {
-    auto i = _hash.begin();
-    while (i != _hash.end()) {
-        if (i->dateUsed() < date) {
-            i = _hash.erase(i);
-        } else {
-            i++;
+    const qint32 day = static_cast<qint32>(date.toJulianDay());
+    for (auto& s : qAsConst(_shards)) {
+        QMutexLocker lock(&s->mutex);
+        for (int i = 0; i < s->slots.count(); i++) {
+            if (s->slots.at(i).used && s->slots.at(i).day < day)
+                s->remove(i);
         }
     }
 }
@@ -87,6 +371,12 @@ HyphenationHash::HashData::HashData(const HyphenatedWord& word)
 {
 }
 
+HyphenationHash::HashData::HashData(const HyphenatedWord& word, const QDate& date_used)
+    : _dateUsed(date_used)
+    , _word(word)
+{
+}
+
 HyphenationHash::HashData::~HashData()
 {
 }
@@ -120,44 +410,94 @@ QStringList HyphenationHash::doHyphenate(const QString& s)
     return findWord(s).splitInfo();
 }
 
+void HyphenationHash::doHyphenateBreaks(const QString& s, HyphenBreaks& breaks)
+{
+    const HyphenBreaks word_breaks = findWord(s).breaks();
+    breaks.append(word_breaks.constData(), word_breaks.size());
+}
+
 QDataStream& operator<<(QDataStream& stream, const HyphenationHash& data)
 {
-    return stream << data._hash;
+    return stream << data.toStreamHash();
 }
 
 QDataStream& operator>>(QDataStream& stream, HyphenationHash& data)
 {
-    stream >> data._hash;
+    HyphenationHash::StreamHash hash;
+    stream >> hash;
+    data.clear();
     if (stream.status() != QDataStream::Ok) {
-        data._hash.clear();
         qDebug() << "HyphenationHash: load from stream error";
+        return stream;
+    }
+
+    for (auto i = hash.begin(); i != hash.end(); ++i) {
+        // ключи в старых файлах могли быть получены от не нормализованного текста, поэтому не используются
+        if (!i->word().text().isEmpty())
+            data.insert(i->word(), static_cast<qint32>(i->dateUsed().toJulianDay()));
     }
     return stream;
 }
 
-HyphenationHash* GlobalHyphenationHash::_hyphenationHash = nullptr;
-Hyphenator* GlobalHyphenationHash::_hyphenator = nullptr;
-GlobalHyphenationHash::Initializer GlobalHyphenationHash::_initializer;
+//! Глобальный хэш переносов. Хэш объявлен после механизма разбиения, поэтому удаляется раньше него
+struct GlobalHyphenationHashData
+{
+    HyphenatorFast hyphenator;
+    HyphenationHash hash {&hyphenator};
+};
 
-GlobalHyphenationHash::Initializer::Initializer()
+//! Хэши зарегистрированных языков. Хэш языка создается один раз, после чего читается без блокировки
+struct GlobalLanguageHashData
 {
-}
+    GlobalLanguageHashData()
+    {
+        for (auto& h : hashes) {
+            h.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    //! Блокировка только для создания хэша
+    QMutex mutex;
+    std::atomic<HyphenationHash*> hashes[QLocale::LastLanguage + 1];
+    //! Владение хэшами
+    QVector<std::shared_ptr<HyphenationHash>> owned;
+};
 
-GlobalHyphenationHash::Initializer::~Initializer()
+HyphenationHash* GlobalHyphenationHash::hash()
 {
-    //    if (GlobalHyphenationHash::_hyphenationHash) {
-    //        delete GlobalHyphenationHash::_hyphenationHash;
-    //        delete GlobalHyphenationHash::_hyphenator;
-    //    }
+    // инициализация локальной статической переменной потокобезопасна
+    static GlobalHyphenationHashData data;
+    return &data.hash;
 }
 
-HyphenationHash* GlobalHyphenationHash::hash()
+HyphenationHash* GlobalHyphenationHash::hash(QLocale::Language language)
 {
-    if (!_hyphenationHash) {
-        _hyphenator = new HyphenatorFast();
-        _hyphenationHash = new HyphenationHash(_hyphenator);
+    // язык может быть зарегистрирован позже, поэтому для незарегистрированного языка ничего не запоминается
+    if (language == QLocale::AnyLanguage || !HyphenationLanguages::isRegistered(language))
+        return hash();
+
+    // создается после реестра языков (см. HyphenationLanguages::isRegistered), поэтому удаляется раньше механизмов
+    // разбиения, которыми владеет реестр
+    static GlobalLanguageHashData data;
+
+    HyphenationHash* language_hash = data.hashes[language].load(std::memory_order_acquire);
+    if (language_hash != nullptr)
+        return language_hash;
+
+    QMutexLocker lock(&data.mutex);
+    language_hash = data.hashes[language].load(std::memory_order_relaxed);
+    if (language_hash == nullptr) {
+        Hyphenator* hyphenator = HyphenationLanguages::hyphenator(language);
+        if (hyphenator == nullptr) {
+            // шаблоны не загрузились, повторно их не загружаем
+            language_hash = hash();
+        } else {
+            data.owned << std::make_shared<HyphenationHash>(hyphenator);
+            language_hash = data.owned.last().get();
+        }
+        data.hashes[language].store(language_hash, std::memory_order_release);
     }
-    return GlobalHyphenationHash::_hyphenationHash;
+    return language_hash;
 }
 
 QDataStream& operator<<(QDataStream& stream, const HyphenationHash::HashData& data)
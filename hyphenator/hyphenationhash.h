@@ -4,12 +4,18 @@
 #include <QDataStream>
 #include <QFile>
 #include <QDate>
+#include <QLocale>
+#include <QVector>
+#include <QMutex>
+#include <atomic>
+#include <memory>
 #include "hyphenator.h"
 #include "hyphenatorfast.h"
 
 namespace Hyphenation
 {
 class HyphenationHash;
+class HyphenationDictionary;
 
 HYPHENATOR_DLL_API QDataStream& operator<<(QDataStream& stream, const HyphenationHash& data);
 HYPHENATOR_DLL_API QDataStream& operator>>(QDataStream& stream, HyphenationHash& data);
@@ -18,6 +24,10 @@ HYPHENATOR_DLL_API QDataStream& operator>>(QDataStream& stream, HyphenationHash&
 //! Экземпляр класса HyphenationHash должен быть один на все приложение
 //! При желании может использоваться как производный класс от Hyphenator. В таком случае используется
 //! Hyphenator::hyphenate
+//! Потокобезопасен: хэш разбит на сегменты со своими блокировками. Размер ограничен бюджетом памяти, при превышении
+//! которого давно не использованные слова вытесняются (алгоритм CLOCK)
+//! Может быть подключен словарь в файле (HyphenationDictionary). Тогда хэш хранит только слова, которых нет в словаре,
+//! и их можно перенести в словарь через compactDictionary
 class HYPHENATOR_DLL_API HyphenationHash : public Hyphenator
 {
     //! Данные в хэше. Служебный класс для HyphenationHash
@@ -26,6 +36,7 @@ class HYPHENATOR_DLL_API HyphenationHash : public Hyphenator
     public:
         HashData();
         HashData(const HyphenatedWord& word);
+        HashData(const HyphenatedWord& word, const QDate& date_used);
         ~HashData();
 
         HyphenatedWord& word();
@@ -49,11 +60,35 @@ class HYPHENATOR_DLL_API HyphenationHash : public Hyphenator
     friend HYPHENATOR_DLL_API QDataStream& operator>>(QDataStream& stream, HyphenationHash& data);
 
 public:
-    HyphenationHash(Hyphenator* hyphenator);
+    HyphenationHash(Hyphenator* hyphenator,
+                    //! Бюджет памяти в байтах (приблизительно)
+                    qint64 max_cost = 16 * 1024 * 1024);
     ~HyphenationHash();
     //! Разбить слово на слоги. При наличии подобного слова в хэше, значение берется оттуда. Иначе разбивается на слоги
-    //! и добавляется в хэш
+    //! и добавляется в хэш. Слово нормализуется через QString::simplified
     HyphenatedWord findWord(const QString& text);
+
+    //! Бюджет памяти в байтах (приблизительно)
+    qint64 maxCost() const;
+    void setMaxCost(qint64 max_cost);
+    //! Занимаемая память в байтах (приблизительно)
+    qint64 totalCost() const;
+    //! Количество слов
+    int count() const;
+    //! Очистить
+    void clear();
+    //! Добавить уже разбитые слова (например результат Hyphenator::hyphenateBatch). Слова из словаря не добавляются
+    void insertWords(const QVector<HyphenatedWord>& words);
+
+    //! Подключить словарь. Слова, найденные в словаре, в хэш не добавляются
+    void setDictionary(const std::shared_ptr<HyphenationDictionary>& dictionary);
+    //! Подключенный словарь
+    std::shared_ptr<HyphenationDictionary> dictionary() const;
+    //! Открыть и подключить словарь из файла
+    bool openDictionary(const QString& file_name);
+    //! Записать в файл словарь, объединенный со словами из хэша, и подключить его. Слова из хэша имеют приоритет
+    bool compactDictionary(const QString& file_name);
+
     //! Сохранить хэш в файл
     bool saveToFile(QFile& file);
     //! Загрузить хэш из файла
@@ -64,6 +99,8 @@ public:
     Hyphenator* hyphenator() const { return _hyphenator; }
     //! Реализация интерфейса Hyphenator
     QStringList doHyphenate(const QString& s);
+    //! Реализация интерфейса Hyphenator
+    void doHyphenateBreaks(const QString& s, HyphenBreaks& breaks);
 
 private:
 #if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
@@ -71,36 +108,47 @@ private:
 #else
     typedef qulonglong HASH_KEY_TYPE;
 #endif
-
-    QMultiHash<HASH_KEY_TYPE, HashData> _hash;
+    //! Данные для сохранения в стрим (формат файла прежний)
+    typedef QMultiHash<HASH_KEY_TYPE, HashData> StreamHash;
+
+    struct Shard;
+    //! Количество сегментов
+    static const int SHARD_COUNT = 16;
+
+    //! Сегмент для нормализованного слова
+    Shard* shard(const QString& key) const;
+    //! Вставить слово. Если оно уже есть, то возвращается существующее
+    HyphenatedWord insert(const HyphenatedWord& word, qint32 day);
+    //! Вытеснить слова сегмента, пока не уложимся в бюджет. Вызывается под блокировкой сегмента
+    void evict(Shard* shard);
+    //! Данные для сохранения в стрим
+    StreamHash toStreamHash() const;
+
+    //! Текущий день (юлианский). Дата запрашивается у системы не чаще раза в минуту
+    static qint32 currentDay();
+
+    QVector<std::shared_ptr<Shard>> _shards;
+    //! Словарь
+    std::shared_ptr<HyphenationDictionary> _dictionary;
+    mutable QMutex _dictionary_mutex;
+    //! Бюджет памяти
+    std::atomic<qint64> _max_cost;
     Hyphenator* _hyphenator;
 };
 
 //! Статический класс с глобальным объектом HyphenationHash.
 //! Автоматически инициализируется объектом класса HyphenatorFast.
-//! HyphenatorTeX в настоящий момент не используется из-за медленной работы и неполного,
-//! для корректной работы, набора правил.
+//! HyphenatorTeX в настоящий момент не используется из-за неполного, для корректной работы, набора правил и
+//! отсутствия поддержки английского языка.
+//! Для языков, зарегистрированных в HyphenationLanguages, создаются отдельные хэши со своим механизмом разбиения
+//! Хэши создаются потокобезопасно при первом обращении и удаляются при завершении программы
 class HYPHENATOR_DLL_API GlobalHyphenationHash
 {
-    //! Внутренний класс-инициализатор статических переменных в globalHyphenationHash
-    //! Обходное решение из-за отсутствия в с++ статических конструкторов
-    class Initializer
-    {
-    public:
-        Initializer();
-        ~Initializer();
-    };
-
-    friend class Initializer;
-
 public:
     static HyphenationHash* hash();
-
-private:
-    static HyphenationHash* _hyphenationHash; //! Глобальный хэш переносов
-    static Hyphenator* _hyphenator; //! Механизм расстановки переносов для _hyphenationHash
-
-    static Initializer _initializer; //! Обходное решение из-за отсутствия в с++ статических конструкторов
+    //! Хэш для языка. Если язык не зарегистрирован в HyphenationLanguages или его шаблоны не удалось загрузить, то
+    //! возвращается hash()
+    static HyphenationHash* hash(QLocale::Language language);
 };
 
 QDataStream& operator<<(QDataStream& stream, const HyphenationHash::HashData& data);
@@ -0,0 +1,183 @@
+#include "hyphenationlanguages.h"
+#include "hyphenationhash.h"
+#include "hyphenatortex.h"
+#include "tex_trie.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <atomic>
+#include <memory>
+
+namespace Hyphenation
+{
+//! Данные реестра языков
+struct LanguageRegistry
+{
+    //! Язык в реестре
+    struct Language
+    {
+        //! Файл шаблонов TeX
+        QString file_name;
+        //! Механизм разбиения. Для файла шаблонов создается при первом обращении
+        std::shared_ptr<Hyphenator> hyphenator;
+        //! Файл шаблонов не удалось загрузить
+        bool failed = false;
+    };
+
+    LanguageRegistry()
+    {
+        for (auto& s : scripts) {
+            s.store(QLocale::AnyLanguage, std::memory_order_relaxed);
+        }
+        for (auto& r : registered) {
+            r.store(false, std::memory_order_relaxed);
+        }
+        scripts[QChar::Script_Cyrillic].store(QLocale::Russian, std::memory_order_relaxed);
+        scripts[QChar::Script_Latin].store(QLocale::English, std::memory_order_relaxed);
+    }
+
+    //! Блокировка только для регистрации и загрузки шаблонов. Определение языка и проверка регистрации идут без
+    //! блокировки, т.к. выполняются для каждого слова
+    QMutex mutex;
+    QHash<int, Language> languages;
+    //! Язык для письменности
+    std::atomic<int> scripts[QChar::ScriptCount];
+    //! Зарегистрирован ли язык
+    std::atomic<bool> registered[QLocale::LastLanguage + 1];
+    //! Количество зарегистрированных языков
+    std::atomic<int> count {0};
+
+    static LanguageRegistry& instance()
+    {
+        static LanguageRegistry registry;
+        return registry;
+    }
+
+    bool add(QLocale::Language language, const Language& data)
+    {
+        if (language < 0 || language > QLocale::LastLanguage) {
+            Q_ASSERT(false);
+            return false;
+        }
+
+        QMutexLocker lock(&mutex);
+        if (languages.contains(language)) {
+            qDebug() << "HyphenationLanguages: language already registered" << QLocale::languageToString(language);
+            return false;
+        }
+        languages.insert(language, data);
+        registered[language].store(true, std::memory_order_release);
+        count++;
+        return true;
+    }
+};
+
+bool HyphenationLanguages::registerPatternFile(QLocale::Language language, const QString& file_name)
+{
+    Q_ASSERT(language != QLocale::AnyLanguage);
+    Q_ASSERT(!file_name.isEmpty());
+
+    LanguageRegistry::Language data;
+    data.file_name = file_name;
+    return LanguageRegistry::instance().add(language, data);
+}
+
+bool HyphenationLanguages::registerHyphenator(QLocale::Language language, Hyphenator* hyphenator)
+{
+    Q_ASSERT(language != QLocale::AnyLanguage);
+    Q_ASSERT(hyphenator != nullptr);
+
+    LanguageRegistry::Language data;
+    data.hyphenator = std::shared_ptr<Hyphenator>(hyphenator);
+    return LanguageRegistry::instance().add(language, data);
+}
+
+bool HyphenationLanguages::isRegistered(QLocale::Language language)
+{
+    if (language < 0 || language > QLocale::LastLanguage)
+        return false;
+    return LanguageRegistry::instance().registered[language].load(std::memory_order_acquire);
+}
+
+bool HyphenationLanguages::isEmpty()
+{
+    return LanguageRegistry::instance().count == 0;
+}
+
+QList<QLocale::Language> HyphenationLanguages::languages()
+{
+    LanguageRegistry& registry = LanguageRegistry::instance();
+    QMutexLocker lock(&registry.mutex);
+
+    QList<QLocale::Language> res;
+    for (auto i = registry.languages.constBegin(); i != registry.languages.constEnd(); ++i)
+        res << static_cast<QLocale::Language>(i.key());
+    return res;
+}
+
+Hyphenator* HyphenationLanguages::hyphenator(QLocale::Language language)
+{
+    LanguageRegistry& registry = LanguageRegistry::instance();
+    QMutexLocker lock(&registry.mutex);
+
+    auto i = registry.languages.find(language);
+    if (i == registry.languages.end() || i->failed)
+        return nullptr;
+
+    if (i->hyphenator == nullptr) {
+        // файл отображается в память, поэтому загрузка под блокировкой не копирует таблицы
+        auto trie = std::make_shared<TeXTrie>();
+        if (!trie->load(i->file_name)) {
+            qDebug() << "HyphenationLanguages: can't load patterns" << QLocale::languageToString(language) << i->file_name;
+            i->failed = true;
+            return nullptr;
+        }
+        i->hyphenator = std::make_shared<HyphenatorTeX>(trie);
+    }
+
+    return i->hyphenator.get();
+}
+
+void HyphenationLanguages::setScriptLanguage(QChar::Script script, QLocale::Language language)
+{
+    Q_ASSERT(script >= 0 && script < QChar::ScriptCount);
+    LanguageRegistry::instance().scripts[script].store(language, std::memory_order_relaxed);
+}
+
+QLocale::Language HyphenationLanguages::detectLanguage(const QString& text)
+{
+    for (const QChar& c : text) {
+        if (!c.isLetter())
+            continue;
+
+        const QChar::Script script = c.script();
+        if (script < 0 || script >= QChar::ScriptCount)
+            return QLocale::AnyLanguage;
+        return static_cast<QLocale::Language>(LanguageRegistry::instance().scripts[script].load(std::memory_order_relaxed));
+    }
+    return QLocale::AnyLanguage;
+}
+
+MultiLanguageHyphenator::MultiLanguageHyphenator()
+{
+}
+
+MultiLanguageHyphenator::~MultiLanguageHyphenator()
+{
+}
+
+QStringList MultiLanguageHyphenator::doHyphenate(const QString& s)
+{
+    HyphenBreaks breaks;
+    doHyphenateBreaks(s, breaks);
+    return splitByBreaks(s, breaks);
+}
+
+void MultiLanguageHyphenator::doHyphenateBreaks(const QString& s, HyphenBreaks& breaks)
+{
+    // пока языки не зарегистрированы, определять язык не нужно
+    QLocale::Language language = HyphenationLanguages::isEmpty() ? QLocale::AnyLanguage : HyphenationLanguages::detectLanguage(s);
+    GlobalHyphenationHash::hash(language)->doHyphenateBreaks(s, breaks);
+}
+} // namespace Hyphenation
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "hyphenator.h"
+
+#include <QChar>
+#include <QList>
+#include <QLocale>
+
+namespace Hyphenation
+{
+//! Реестр механизмов разбиения на слоги для разных языков
+//! Шаблоны языка задаются двоичным файлом (tools/tex_trie_gen <файл .bin> <шаблоны TeX>), который отображается в память
+//! только при первом обращении к языку. Язык строки определяется по письменности ее первой буквы.
+//! Если язык не зарегистрирован, то используется HyphenatorFast (русский и английский)
+//! Все методы потокобезопасны. Повторная регистрация языка не допускается: механизм разбиения языка используется
+//! глобальным хэшем до завершения программы
+class HYPHENATOR_DLL_API HyphenationLanguages
+{
+public:
+    //! Зарегистрировать файл шаблонов TeX для языка. Файл загружается при первом обращении к языку
+    static bool registerPatternFile(QLocale::Language language, const QString& file_name);
+    //! Зарегистрировать механизм разбиения для языка. Реестр становится владельцем hyphenator
+    static bool registerHyphenator(QLocale::Language language, Hyphenator* hyphenator);
+    //! Зарегистрирован ли язык
+    static bool isRegistered(QLocale::Language language);
+    //! Зарегистрирован ли хотя бы один язык
+    static bool isEmpty();
+    //! Зарегистрированные языки
+    static QList<QLocale::Language> languages();
+    //! Механизм разбиения для языка. При первом обращении загружается файл шаблонов. nullptr, если язык не
+    //! зарегистрирован или файл не удалось загрузить
+    static Hyphenator* hyphenator(QLocale::Language language);
+
+    //! Сопоставить письменность языку. По умолчанию кириллица - русский, латиница - английский
+    static void setScriptLanguage(QChar::Script script, QLocale::Language language);
+    //! Язык строки по письменности ее первой буквы. QLocale::AnyLanguage, если букв нет или письменность неизвестна
+    static QLocale::Language detectLanguage(const QString& text);
+};
+
+//! Разбиение на слоги с выбором языка для каждой строки (HyphenationLanguages::detectLanguage). Разбиение выполняется
+//! через хэш языка GlobalHyphenationHash::hash(QLocale::Language)
+class HYPHENATOR_DLL_API MultiLanguageHyphenator : public Hyphenator
+{
+public:
+    MultiLanguageHyphenator();
+    ~MultiLanguageHyphenator();
+    //! Реализация интерфейса Hyphenator
+    QStringList doHyphenate(const QString& s);
+    //! Реализация интерфейса Hyphenator
+    void doHyphenateBreaks(const QString& s, HyphenBreaks& breaks);
+};
+} // namespace Hyphenation
@@ -1,12 +1,12 @@
 #include "hyphenator.h"
+#include "hyphenationhash.h"
 #include <QStringList>
 #include <QDataStream>
-#include <QRegularExpression>
-
-QString utf(const char* sourcetext)
-{
-    return QString::fromUtf8(sourcetext);
-};
+#include <QHash>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <atomic>
 
 namespace Hyphenation
 {
@@ -16,12 +16,37 @@ Hyphenator::~Hyphenator()
 
 void Hyphenator::hyphenate(HyphenatedWord& word)
 {
-    if (word.text().isEmpty()) {
-        word._splitInfo = QStringList();
-    } else if (word.isAbbreviation()) {
-        word._splitInfo = QStringList(word.text());
-    } else {
-        word._splitInfo = doHyphenate(word.text());
+    word._breaks.clear();
+    if (!word.text().isEmpty() && !word.isAbbreviation())
+        doHyphenateBreaks(word.text(), word._breaks);
+    word._hyphenated = true;
+}
+
+void Hyphenator::doHyphenateBreaks(const QString& s, HyphenBreaks& breaks)
+{
+    breaksFromSplit(doHyphenate(s), breaks);
+}
+
+QStringList Hyphenator::splitByBreaks(const QString& s, const HyphenBreaks& breaks)
+{
+    QStringList res;
+    res.reserve(breaks.size() + 1);
+    int pos = 0;
+    for (int offset : breaks) {
+        res.append(s.mid(pos, offset - pos));
+        pos = offset;
+    }
+    res.append(s.mid(pos));
+    return res;
+}
+
+void Hyphenator::breaksFromSplit(const QStringList& split, HyphenBreaks& breaks)
+{
+    int pos = 0;
+    for (int i = 0; i < split.count() - 1; i++) {
+        pos += split.at(i).size();
+        if (pos > 0 && (breaks.isEmpty() || breaks.last() < pos))
+            breaks.append(pos);
     }
 }
 
@@ -45,6 +70,127 @@ void Hyphenator::hyphenate(HyphenatedPhrase& phrase)
     }
 }
 
+//! Общие данные задач hyphenateBatch
+struct BatchHyphenationData
+{
+    Hyphenator* hyphenator = nullptr;
+    //! Слова. Каждое слово изменяет только один поток
+    HyphenatedWord* words = nullptr;
+    int word_count = 0;
+    //! Следующий необработанный блок слов
+    std::atomic<int> next_chunk {0};
+    int chunk_count = 0;
+    int chunk_size = 0;
+    //! Освобождается задачей по окончании
+    QSemaphore finished;
+
+    //! Обрабатывать блоки, пока они не закончатся
+    void process()
+    {
+        for (int chunk = next_chunk++; chunk < chunk_count; chunk = next_chunk++) {
+            const int end = qMin(word_count, (chunk + 1) * chunk_size);
+            for (int i = chunk * chunk_size; i < end; i++) {
+                hyphenator->hyphenate(words[i]);
+            }
+        }
+    }
+};
+
+//! Задача пула потоков для hyphenateBatch
+class BatchHyphenationTask : public QRunnable
+{
+public:
+    BatchHyphenationTask(BatchHyphenationData* data)
+        : _data(data)
+    {
+    }
+    void run() override
+    {
+        _data->process();
+        _data->finished.release();
+    }
+
+private:
+    BatchHyphenationData* _data;
+};
+
+QVector<HyphenatedPhrase> Hyphenator::hyphenateBatch(const QStringList& texts, HyphenationHash* warm_hash, QThreadPool* pool)
+{
+    // Минимальное количество слов в блоке, который обрабатывает один поток
+    static const int min_chunk_size = 64;
+
+    // уникальные слова
+    QVector<HyphenatedPhrase> res;
+    res.reserve(texts.count());
+    QHash<QString, int> word_index;
+    QVector<HyphenatedWord> words;
+    QVector<QVector<int>> phrase_words(texts.count());
+    for (int t = 0; t < texts.count(); t++) {
+        res << HyphenatedPhrase(texts.at(t));
+        // как в hyphenate(HyphenatedPhrase&): фраза уже нормализована через simplified
+        const QStringList split = res.constLast().text().split(' ',
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+                                                             Qt::SkipEmptyParts
+#else
+                                                             QString::SkipEmptyParts
+#endif
+        );
+        phrase_words[t].reserve(split.count());
+        for (auto& w : split) {
+            auto it = word_index.constFind(w);
+            if (it == word_index.constEnd()) {
+                it = word_index.insert(w, words.count());
+                words << HyphenatedWord(w);
+            }
+            phrase_words[t] << it.value();
+        }
+    }
+
+    BatchHyphenationData data;
+    data.hyphenator = this;
+    data.words = words.data();
+    data.word_count = words.count();
+    data.chunk_size = min_chunk_size;
+    data.chunk_count = (words.count() + min_chunk_size - 1) / min_chunk_size;
+
+    if (data.chunk_count > 1) {
+        if (pool == nullptr)
+            pool = QThreadPool::globalInstance();
+
+        // задачи запускаются только на свободных потоках, чтобы вызов из потока того же пула не привел к взаимной
+        // блокировке. Остальные блоки обрабатывает вызывающий поток
+        int started = 0;
+        const int max_tasks = qMin(data.chunk_count - 1, pool->maxThreadCount());
+        for (int i = 0; i < max_tasks; i++) {
+            auto task = new BatchHyphenationTask(&data);
+            if (!pool->tryStart(task)) {
+                delete task;
+                break;
+            }
+            started++;
+        }
+
+        data.process();
+        data.finished.acquire(started);
+
+    } else {
+        data.process();
+    }
+
+    if (warm_hash != nullptr)
+        warm_hash->insertWords(words);
+
+    for (int t = 0; t < res.count(); t++) {
+        auto& phrase = res[t];
+        phrase._hyphenatedWords.reserve(phrase_words.at(t).count());
+        for (int i : phrase_words.at(t)) {
+            phrase._hyphenatedWords << words.at(i);
+        }
+    }
+
+    return res;
+}
+
 HyphenatedWord::HyphenatedWord()
     : HyphenatedItem()
 {
@@ -55,18 +201,33 @@ HyphenatedWord::HyphenatedWord(const QString& text)
 {
 }
 
+HyphenatedWord::HyphenatedWord(const QString& text, const HyphenBreaks& breaks)
+    : HyphenatedItem(text)
+    , _breaks(breaks)
+    , _hyphenated(true)
+{
+}
+
 HyphenatedWord::~HyphenatedWord()
 {
 }
 
 bool HyphenatedWord::isHyphenated() const
 {
-    return text().isEmpty() || _splitInfo.count() > 0;
+    return text().isEmpty() || _hyphenated;
 }
 
 QStringList HyphenatedWord::splitInfo() const
 {
-    return _splitInfo;
+    if (text().isEmpty() || !_hyphenated)
+        return QStringList();
+
+    return Hyphenator::splitByBreaks(text(), _breaks);
+}
+
+HyphenBreaks HyphenatedWord::breaks() const
+{
+    return _breaks;
 }
 
 bool HyphenatedWord::isAbbreviation() const
@@ -78,7 +239,8 @@ HyphenatedWord& HyphenatedWord::operator=(const HyphenatedWord& item)
 {
     if (&item != this) {
         HyphenatedItem::operator=(item);
-        _splitInfo = item._splitInfo;
+        _breaks = item._breaks;
+        _hyphenated = item._hyphenated;
     }
     return *this;
 }
@@ -149,12 +311,19 @@ HyphenatedItem& HyphenatedItem::operator=(const HyphenatedItem& item)
 
 QDataStream& operator<<(QDataStream& stream, const HyphenatedWord& data)
 {
-    return stream << data._text << data._splitInfo;
+    // формат файла прежний - разбивка по слогам
+    return stream << data._text << data.splitInfo();
 }
 
 QDataStream& operator>>(QDataStream& stream, HyphenatedWord& data)
 {
-    return stream >> data._text >> data._splitInfo;
+    QStringList split_info;
+    stream >> data._text >> split_info;
+
+    data._breaks.clear();
+    Hyphenator::breaksFromSplit(split_info, data._breaks);
+    data._hyphenated = !split_info.isEmpty();
+    return stream;
 }
 
 bool isAbbreviation(const QString& s)
@@ -163,11 +332,48 @@ bool isAbbreviation(const QString& s)
      * 1. Содержит только буквенные символы и все они заглавные. Может содержать дефисы и точки
      * 2. Содержит любые не буквенные символы, за исключением дефиса и точки */
 
-    static const QRegularExpression re1(utf(R"(^[А-Я|A-Z|\-Ё\.]*$)"),
-            QRegularExpression::UseUnicodePropertiesOption); // только буквенные заглавные символы, дефис или точка
-    static const QRegularExpression re2(utf(R"(^[А-Я|а-я|A-Z|a-z|\-ёЁ\.]*$)"),
-            QRegularExpression::UseUnicodePropertiesOption); // только символы, дефис или точка
+    // Ранее условия проверялись регулярными выражениями ^[А-Я|A-Z|\-Ё\.]*$ и ^[А-Я|а-я|A-Z|a-z|\-ёЁ\.]*$.
+    // Таблица повторяет их наборы символов (включая '|'), проверка идет за один проход без ветвлений
+
+    //! Символ допустим в заглавной аббревиатуре: заглавная буква, дефис или точка
+    static const quint8 upper_set = 0x1;
+    //! Символ допустим в обычном слове: буква, дефис или точка
+    static const quint8 word_set = 0x2;
+    //! Размер таблицы (латиница и кириллица). Остальные символы не входят ни в один набор
+    static const int table_size = 0x500;
+
+    static const QVector<quint8> table = []() {
+        QVector<quint8> t(table_size, 0);
+        auto fill = [&t](ushort from, ushort to, quint8 sets) {
+            for (ushort c = from; c <= to; c++) {
+                t[c] = sets;
+            }
+        };
+        fill('A', 'Z', upper_set | word_set);
+        fill(0x0410, 0x042F, upper_set | word_set); // А-Я
+        fill(0x0401, 0x0401, upper_set | word_set); // Ё
+        fill('-', '.', upper_set | word_set);
+        fill('|', '|', upper_set | word_set);
+        fill('a', 'z', word_set);
+        fill(0x0430, 0x044F, word_set); // а-я
+        fill(0x0451, 0x0451, word_set); // ё
+        return t;
+    }();
+
+    const ushort* data = reinterpret_cast<const ushort*>(s.constData());
+    int size = s.size();
+    // $ в регулярном выражении допускал перевод строки в самом конце
+    if (size > 0 && data[size - 1] == '\n')
+        size--;
+
+    // пересечение наборов всех символов
+    const quint8* sets = table.constData();
+    quint8 common = upper_set | word_set;
+    for (int i = 0; i < size; i++) {
+        const ushort c = data[i];
+        common &= c < table_size ? sets[c] : 0;
+    }
 
-    return re1.match(s).hasMatch() || !re2.match(s).hasMatch();
+    return (common & upper_set) != 0 || (common & word_set) == 0;
 }
 } // namespace Hyphenation
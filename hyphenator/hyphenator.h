@@ -13,11 +13,19 @@ Roman Nikulenkov, https://github.com/n-r-w
 #include <QChar>
 #include <QString>
 #include <QStringList>
+#include <QVarLengthArray>
 #include <QVector>
 
+class QThreadPool;
+
 namespace Hyphenation
 {
 class HyphenatedWord;
+class HyphenationHash;
+
+//! Места переносов в слове: смещения символов, перед которыми находится перенос, по возрастанию.
+//! Для типичных слов память в куче не выделяется
+typedef QVarLengthArray<int, 16> HyphenBreaks;
 
 //! Базовый абстрактный класс для слов и предложений, которые будут разбиваться на слоги
 class HYPHENATOR_DLL_API HyphenatedItem
@@ -56,18 +64,25 @@ class HYPHENATOR_DLL_API HyphenatedWord : public HyphenatedItem
 public:
     HyphenatedWord();
     HyphenatedWord(const QString& text);
+    //! Слово с готовой разбивкой на слоги. Места переносов - смещения в text после simplified
+    HyphenatedWord(const QString& text, const HyphenBreaks& breaks);
     ~HyphenatedWord();
     //! Слово разбито на слоги
     bool isHyphenated() const;
     //! Разбивка по слогам
     QStringList splitInfo() const;
+    //! Места переносов (смещения в text)
+    HyphenBreaks breaks() const;
     //! Является ли слово аббревиатурой (т.е. разбивать на слоги его не надо)
     bool isAbbreviation() const;
 
     HyphenatedWord& operator=(const HyphenatedWord& item);
 
 private:
-    QStringList _splitInfo;
+    //! Места переносов
+    HyphenBreaks _breaks;
+    //! Слово разбито на слоги
+    bool _hyphenated = false;
 };
 
 //! Выгрузка HyphenatedWord в стрим
@@ -106,7 +121,23 @@ public:
     void hyphenate(HyphenatedWord& word);
     //! Разбить фразу на слова и слоги
     void hyphenate(HyphenatedPhrase& phrase);
+    //! Разбить набор фраз на слова и слоги. Результат в порядке texts. Повторяющиеся слова разбиваются один раз,
+    //! уникальные слова разбиваются параллельно. Реализация doHyphenateBreaks должна быть потокобезопасной (таковы
+    //! HyphenatorFast, HyphenatorTeX и HyphenationHash)
+    QVector<HyphenatedPhrase> hyphenateBatch(const QStringList& texts,
+                                             //! Если задан, то в него добавляются все разбитые слова
+                                             HyphenationHash* warm_hash = nullptr,
+                                             //! Пул потоков. Если не задан, то QThreadPool::globalInstance()
+                                             QThreadPool* pool = nullptr);
     //! Реализация конкретного алгоритма разбития
     virtual QStringList doHyphenate(const QString& s) = 0;
+    //! Реализация конкретного алгоритма разбития. Места переносов добавляются в breaks. По умолчанию вычисляется через
+    //! doHyphenate; наследники переопределяют, чтобы не создавать строки для слогов
+    virtual void doHyphenateBreaks(const QString& s, HyphenBreaks& breaks);
+
+    //! Разбить строку на слоги по местам переносов
+    static QStringList splitByBreaks(const QString& s, const HyphenBreaks& breaks);
+    //! Получить места переносов по разбивке на слоги
+    static void breaksFromSplit(const QStringList& split, HyphenBreaks& breaks);
 };
 }
@@ -1,108 +1,236 @@
 #include "hyphenatorfast.h"
 
+#include <QQueue>
+#include <algorithm>
+
 namespace Hyphenation
 {
-const QString HyphenatorFast::_x = QString::fromUtf8("йьъ");
-const QString HyphenatorFast::_g = QString::fromUtf8("аеёиоуыэюяaeiouy");
-const QString HyphenatorFast::_s = QString::fromUtf8("бвгджзклмнпрстфхцчшщbcdfghjklmnpqrstvwxz");
+//! Классы символов
+enum CharClass : quint8
+{
+    ClassOther = 0,
+    //! Й, Ь, Ъ
+    ClassX = 1,
+    //! Гласные
+    ClassG = 2,
+    //! Согласные
+    ClassS = 3,
+};
 
-HyphenatorFast::HyphenatorFast()
+//! Правило разбиения: шаблон из классов символов и позиция переноса в шаблоне
+struct HyphenRuleFast
 {
-    _rules.append(HyphenPairFast("xgg", 1));
-    _rules.append(HyphenPairFast("xgs", 1));
-    _rules.append(HyphenPairFast("xsg", 1));
-    _rules.append(HyphenPairFast("xss", 1));
-    _rules.append(HyphenPairFast("gssssg", 3));
-    _rules.append(HyphenPairFast("gsssg", 3));
-    _rules.append(HyphenPairFast("gsssg", 2));
-    _rules.append(HyphenPairFast("sgsg", 2));
-    _rules.append(HyphenPairFast("gssg", 2));
-    _rules.append(HyphenPairFast("sggg", 2));
-    _rules.append(HyphenPairFast("sggs", 2));
-}
+    const char* pattern;
+    int length;
+    int position;
+};
 
-HyphenatorFast::~HyphenatorFast()
+//! Правила в порядке применения. Перенос, вставленный предыдущим правилом, запрещает вхождения, которые через него
+//! проходят
+static const HyphenRuleFast _rules[] = {
+    {"xgg", 3, 1},
+    {"xgs", 3, 1},
+    {"xsg", 3, 1},
+    {"xss", 3, 1},
+    {"gssssg", 6, 3},
+    {"gsssg", 5, 3},
+    {"gsssg", 5, 2},
+    {"sgsg", 4, 2},
+    {"gssg", 4, 2},
+    {"sggg", 4, 2},
+    {"sggs", 4, 2},
+};
+static const int _rule_count = sizeof(_rules) / sizeof(_rules[0]);
+
+//! Размер таблицы классов символов (латиница и кириллица). Остальные символы относятся к ClassOther
+static const int _class_table_size = 0x500;
+
+//! Таблица классов символов
+static const quint8* charClassTable()
 {
+    static const QVector<quint8> table = []() {
+        QVector<quint8> t(_class_table_size, ClassOther);
+        auto fill = [&t](const char* chars, CharClass char_class) {
+            for (const QChar& c : QString::fromUtf8(chars)) {
+                Q_ASSERT(c.unicode() < _class_table_size);
+                t[c.unicode()] = char_class;
+            }
+        };
+        // в обратном порядке приоритета
+        fill("бвгджзклмнпрстфхцчшщbcdfghjklmnpqrstvwxz", ClassS);
+        fill("аеёиоуыэюяaeiouy", ClassG);
+        fill("йьъ", ClassX);
+        return t;
+    }();
+    return table.constData();
 }
 
-static const QChar _separator(0);
+static inline quint8 charClass(const quint8* table, const QChar& c)
+{
+    return c.unicode() < _class_table_size ? table[c.unicode()] : ClassOther;
+}
 
-QStringList HyphenatorFast::doHyphenateInternal(const QString& s)
+//! Детерминированный автомат Ахо-Корасик над шаблонами правил. Алфавит - классы x, g, s. Символ ClassOther
+//! возвращает автомат в начальное состояние
+class RuleAutomatonFast
 {
-    QString hyphenatedText;
-    QString text = s;
-
-    for (QString::ConstIterator c = text.constBegin(); c != text.constEnd(); c++) {
-        if (_x.indexOf(*c) != -1) {
-            hyphenatedText.append('x');
-        } else if (_g.indexOf(*c) != -1) {
-            hyphenatedText.append('g');
-        } else if (_s.indexOf(*c) != -1) {
-            hyphenatedText.append('s');
-        } else {
-            hyphenatedText.append(*c);
+public:
+    RuleAutomatonFast()
+    {
+        Q_ASSERT(_rule_count <= 32);
+        _states.append(State());
+
+        for (int r = 0; r < _rule_count; r++) {
+            int state = 0;
+            for (int i = 0; i < _rules[r].length; i++) {
+                int c = symbol(_rules[r].pattern[i]);
+                if (_states.at(state).next[c] < 0) {
+                    _states.append(State());
+                    _states[state].next[c] = _states.count() - 1;
+                }
+                state = _states.at(state).next[c];
+            }
+            _states[state].output |= 1u << r;
+        }
+
+        // достраиваем переходы по ссылкам неудач
+        QQueue<int> queue;
+        for (int c = 0; c < 3; c++) {
+            int child = _states.at(0).next[c];
+            if (child < 0) {
+                _states[0].next[c] = 0;
+            } else {
+                _states[child].fail = 0;
+                queue.enqueue(child);
+            }
         }
-    }
 
-    for (RulesFast::ConstIterator hp = _rules.constBegin(); hp != _rules.constEnd(); hp++) {
-        int index = hyphenatedText.indexOf(hp->pattern);
-        while (index != -1) {
-            int actualIndex = index + hp->position;
-            hyphenatedText = hyphenatedText.mid(0, actualIndex) + _separator + hyphenatedText.mid(actualIndex);
-            text = text.mid(0, actualIndex) + _separator + text.mid(actualIndex);
-            index = hyphenatedText.indexOf(hp->pattern);
+        while (!queue.isEmpty()) {
+            int state = queue.dequeue();
+            for (int c = 0; c < 3; c++) {
+                int child = _states.at(state).next[c];
+                int fail_next = _states.at(_states.at(state).fail).next[c];
+                if (child < 0) {
+                    _states[state].next[c] = fail_next;
+                } else {
+                    _states[child].fail = fail_next;
+                    _states[child].output |= _states.at(fail_next).output;
+                    queue.enqueue(child);
+                }
+            }
         }
     }
 
-    QStringList nodes;
-    int index = text.indexOf(_separator);
-    int i = 0;
-    while (index >= 0) {
-        nodes.append(text.mid(0, index));
-        text = text.mid(index + 1);
-        index = text.indexOf(_separator);
-        i++;
+    //! Переход по классу символа
+    int next(int state, quint8 char_class) const { return char_class == ClassOther ? 0 : _states.at(state).next[char_class - 1]; }
+    //! Правила, вхождения которых заканчиваются в состоянии (битовая маска по индексу правила)
+    quint32 output(int state) const { return _states.at(state).output; }
+
+private:
+    struct State
+    {
+        int next[3] = {-1, -1, -1};
+        int fail = 0;
+        quint32 output = 0;
+    };
+
+    static int symbol(char c)
+    {
+        switch (c) {
+            case 'x':
+                return ClassX - 1;
+            case 'g':
+                return ClassG - 1;
+            default:
+                Q_ASSERT(c == 's');
+                return ClassS - 1;
+        }
     }
-    nodes.append(text);
-    return nodes;
+
+    QVector<State> _states;
+};
+
+HyphenatorFast::HyphenatorFast()
+{
 }
 
-QStringList HyphenatorFast::doHyphenate(const QString& s)
+HyphenatorFast::~HyphenatorFast()
 {
-    // Проверка на наличие дефисов. Если они есть, то заранее разделяем по ним слово
-    QStringList split = s.split('-',
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
-                                Qt::SkipEmptyParts
-#else
-                                QString::SkipEmptyParts
-#endif
-                                ,
-                                Qt::CaseInsensitive);
-
-    QStringList nodes;
-    for (int i = 0; i < split.count(); i++) {
-        if (i != split.count() - 1) {
-            nodes.append(doHyphenateInternal(split.at(i) + '-'));
-        } else {
-            nodes.append(doHyphenateInternal(split.at(i)));
-        }
-    }
-    return nodes;
 }
 
-HyphenatorFast::HyphenPairFast::HyphenPairFast()
-    : position(0)
+void HyphenatorFast::findBreaks(const QChar* text, int size, int offset, HyphenBreaks& breaks)
 {
+    static const RuleAutomatonFast automaton;
+    const quint8* table = charClassTable();
+
+    // для каждого символа - правила, вхождения которых на нем заканчиваются
+    QVarLengthArray<quint32, 64> matches(size);
+    quint32 matched_rules = 0;
+    int state = 0;
+    for (int i = 0; i < size; i++) {
+        state = automaton.next(state, charClass(table, text[i]));
+        matches[i] = automaton.output(state);
+        matched_rules |= matches[i];
+    }
+
+    if (matched_rules == 0)
+        return;
+
+    // Правила применяются по порядку, вхождения слева направо. Вхождение, через которое уже проходит перенос, не
+    // учитывается. Это дает тот же результат, что и последовательная вставка разделителей в строку
+    QVarLengthArray<bool, 64> found(size + 1);
+    std::fill(found.begin(), found.end(), false);
+    for (int r = 0; r < _rule_count; r++) {
+        if ((matched_rules & (1u << r)) == 0)
+            continue;
+
+        const HyphenRuleFast& rule = _rules[r];
+        for (int end = rule.length - 1; end < size; end++) {
+            if ((matches.at(end) & (1u << r)) == 0)
+                continue;
+
+            int start = end - rule.length + 1;
+            bool crossed = false;
+            for (int i = start + 1; i <= end; i++) {
+                if (found.at(i)) {
+                    crossed = true;
+                    break;
+                }
+            }
+            if (!crossed)
+                found[start + rule.position] = true;
+        }
+    }
+
+    for (int i = 1; i < size; i++) {
+        if (found.at(i))
+            breaks.append(offset + i);
+    }
 }
 
-HyphenatorFast::HyphenPairFast::HyphenPairFast(QString pattern, int position)
-    : pattern(pattern)
-    , position(position)
+QStringList HyphenatorFast::doHyphenate(const QString& s)
 {
+    HyphenBreaks breaks;
+    doHyphenateBreaks(s, breaks);
+    return splitByBreaks(s, breaks);
 }
 
-HyphenatorFast::HyphenPairFast::~HyphenPairFast()
+void HyphenatorFast::doHyphenateBreaks(const QString& s, HyphenBreaks& breaks)
 {
+    // Проверка на наличие дефисов. Если они есть, то заранее разделяем по ним слово. Дефис остается в конце части
+    const int size = s.size();
+    int start = 0;
+    while (start < size) {
+        int end = s.indexOf('-', start);
+        end = (end < 0) ? size : end + 1;
+
+        // перенос после дефиса, если с обеих сторон от него есть текст
+        if (start > 1 && s.at(start - 2) != '-' && s.at(start) != '-')
+            breaks.append(start);
+
+        findBreaks(s.constData() + start, end - start, start, breaks);
+        start = end;
+    }
 }
 
 } // namespace Hyphenation
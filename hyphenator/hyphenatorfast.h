@@ -11,31 +11,17 @@ namespace Hyphenation
 //! Работает с английским и русским языком
 class HYPHENATOR_DLL_API HyphenatorFast : public Hyphenator
 {
-    //! Служебный класс для HyphenatorFast
-    struct HyphenPairFast
-    {
-        HyphenPairFast();
-        HyphenPairFast(QString pattern, int position);
-        ~HyphenPairFast();
-        QString pattern;
-        int position;
-    };
-    typedef QVector<HyphenPairFast> RulesFast;
-
 public:
     HyphenatorFast();
     ~HyphenatorFast();
     //! Реализация конкретного алгоритма разбития
     QStringList doHyphenate(const QString& s);
+    //! Реализация конкретного алгоритма разбития. Сначала слово делится по дефисам, а затем части разбиваются на слоги
+    void doHyphenateBreaks(const QString& s, HyphenBreaks& breaks);
 
 private:
-    //! Правила
-    RulesFast _rules;
-    //! Сначала doHyphenate делит слово по дефисам, а затем вызывает этот алгоритм разбиения на слоги
-    QStringList doHyphenateInternal(const QString& s);
-
-    static const QString _x;
-    static const QString _g;
-    static const QString _s;
+    //! Найти места переносов за один проход автомата по классам символов. В breaks добавляются смещения символов
+    //! (с учетом offset), перед которыми находится перенос
+    static void findBreaks(const QChar* text, int size, int offset, HyphenBreaks& breaks);
 };
 }
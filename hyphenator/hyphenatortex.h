@@ -2,39 +2,39 @@
 
 #include "hyphenator.h"
 
+#include <memory>
+
 namespace Hyphenation
 {
+class TeXTrie;
+
 //! Алгоритм Ляна-Кнута (редактор TeX)
 //! http://habrahabr.ru/post/138088/
-//! Работает не быстро, но при наличии корректных правил - точно
-//! Реализована поддержка только русского языка
+//! При наличии корректных правил - точно. Шаблоны упакованы в префиксное дерево, общее для всех экземпляров
+//! Встроенные шаблоны - только для русского языка. Шаблоны других языков можно загрузить из файла
+//! (см. HyphenationLanguages)
 class HYPHENATOR_DLL_API HyphenatorTeX : public Hyphenator
 {
-    //! Шаблон TeX (cлужебный класс для Hyphenator)
-    struct PatternItemTeX
-    {
-        PatternItemTeX();
-        void clear();
-
-        QString str;
-        QVector<int> levels;
-    };
-    typedef QVector<PatternItemTeX> PatternListTeX;
-
-    friend bool pattern_compare(const PatternItemTeX& a, const PatternItemTeX& b);
-
 public:
+    //! Встроенные русские шаблоны
     HyphenatorTeX() {}
+    //! Шаблоны из заранее построенного дерева
+    explicit HyphenatorTeX(const std::shared_ptr<const TeXTrie>& trie)
+        : _trie(trie)
+    {
+    }
     ~HyphenatorTeX() {}
     //! Реализация конкретного алгоритма разбития
     QStringList doHyphenate(const QString& s);
+    //! Реализация конкретного алгоритма разбития
+    void doHyphenateBreaks(const QString& s, HyphenBreaks& breaks);
 
 private:
-    //! Загрузить шаблоны
-    void loadPatternsTeX();
-    //! Инициализировать шаблон
-    void createPattern(PatternItemTeX& pattern, const QString& str);
-    //! Список шаблонов
-    PatternListTeX _patterns;
+    //! Дерево шаблонов. Если определен HYPHENATOR_GENERATED_PATTERNS, то используются таблицы, построенные на этапе
+    //! сборки, иначе дерево строится при первом обращении
+    static const TeXTrie& patternTrie();
+
+    //! Дерево шаблонов, если они заданы не встроенные
+    std::shared_ptr<const TeXTrie> _trie;
 };
 }
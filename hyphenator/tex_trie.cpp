@@ -0,0 +1,307 @@
+#include "tex_trie.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QMap>
+#include <QQueue>
+#include <QSaveFile>
+#include <QString>
+#include <algorithm>
+#include <cstring>
+
+namespace Hyphenation
+{
+static const QChar _marker('.');
+
+//! Заголовок двоичного файла шаблонов. За ним следуют узлы, символы переходов, узлы переходов и уровни, каждый раздел
+//! выровнен на 4 байта
+struct TeXTrieFileHeader
+{
+    char magic[4];
+    quint32 version;
+    quint32 node_count;
+    quint32 edge_count;
+    quint32 level_count;
+};
+
+//! Сигнатура двоичного файла шаблонов
+static const char _file_magic[4] = {'H', 'Y', 'P', 'T'};
+//! Версия формата
+static const quint32 _file_version = 1;
+
+static quint32 align4(quint32 value)
+{
+    return (value + 3) & ~quint32(3);
+}
+
+//! Разобрать шаблон TeX на строку и уровни переноса. Для маркера границы слова уровень не заводится
+static void parsePattern(const QString& source, QString& str, QVector<quint8>& levels)
+{
+    str.clear();
+    levels.clear();
+    bool wait_digit = true;
+
+    for (const QChar& c : source) {
+        if (c >= '0' && c <= '9') {
+            levels.append(static_cast<quint8>(c.unicode() - '0'));
+            wait_digit = false;
+        } else {
+            if (c != _marker && wait_digit)
+                levels.append(0);
+            str.append(c);
+            wait_digit = true;
+        }
+    }
+
+    if (wait_digit)
+        levels.append(0);
+}
+
+TeXTrie::TeXTrie()
+{
+}
+
+TeXTrie::TeXTrie(const char* const* patterns)
+{
+    build(patterns);
+}
+
+TeXTrie::TeXTrie(const TeXTrieNode* nodes, int node_count, const ushort* edge_chars, const quint32* edge_targets,
+                 const quint8* levels)
+{
+    attach(nodes, node_count, edge_chars, edge_targets, levels);
+}
+
+void TeXTrie::build(const char* const* patterns)
+{
+    QStringList list;
+    for (int i = 0; patterns[i] != nullptr; i++) {
+        list << QString::fromUtf8(patterns[i]);
+    }
+    build(list);
+}
+
+void TeXTrie::build(const QStringList& patterns)
+{
+    // Промежуточное дерево с переходами в QMap, чтобы переходы сразу были отсортированы
+    struct BuildNode
+    {
+        QMap<ushort, int> children;
+        QVector<quint8> levels;
+        bool terminal = false;
+    };
+    QVector<BuildNode> tree(1);
+
+    QString str;
+    QVector<quint8> levels;
+    for (auto& pattern : patterns) {
+        if (pattern.isEmpty())
+            continue;
+        parsePattern(pattern, str, levels);
+
+        int node = 0;
+        for (const QChar& c : qAsConst(str)) {
+            auto it = tree[node].children.constFind(c.unicode());
+            if (it == tree[node].children.constEnd()) {
+                tree.append(BuildNode());
+                tree[node].children.insert(c.unicode(), tree.count() - 1);
+                node = tree.count() - 1;
+            } else {
+                node = it.value();
+            }
+        }
+
+        // при повторе шаблона действует первый
+        if (!tree[node].terminal) {
+            tree[node].terminal = true;
+            tree[node].levels = levels;
+        }
+    }
+
+    // Упаковка в ширину: переходы каждого узла лежат подряд
+    _node_data.clear();
+    _edge_char_data.clear();
+    _edge_target_data.clear();
+    _level_data.clear();
+
+    QVector<int> packed_index(tree.count(), -1);
+    QQueue<int> queue;
+    queue.enqueue(0);
+    packed_index[0] = 0;
+    QVector<int> order;
+    order.reserve(tree.count());
+    while (!queue.isEmpty()) {
+        int node = queue.dequeue();
+        order << node;
+        for (auto it = tree.at(node).children.constBegin(); it != tree.at(node).children.constEnd(); ++it) {
+            packed_index[it.value()] = order.count() + queue.count();
+            queue.enqueue(it.value());
+        }
+    }
+
+    _node_data.resize(order.count());
+    for (int i = 0; i < order.count(); i++) {
+        const BuildNode& node = tree.at(order.at(i));
+        TeXTrieNode& packed = _node_data[i];
+        packed.first_edge = static_cast<quint32>(_edge_char_data.count());
+        packed.edge_count = static_cast<quint32>(node.children.count());
+        packed.levels_offset = static_cast<quint32>(_level_data.count());
+        packed.levels_count = node.terminal ? static_cast<quint32>(node.levels.count()) : 0;
+
+        for (auto it = node.children.constBegin(); it != node.children.constEnd(); ++it) {
+            _edge_char_data << it.key();
+            _edge_target_data << static_cast<quint32>(packed_index.at(it.value()));
+        }
+        if (node.terminal)
+            _level_data += node.levels;
+    }
+
+    attach(_node_data.constData(), _node_data.count(), _edge_char_data.constData(), _edge_target_data.constData(),
+           _level_data.constData());
+}
+
+void TeXTrie::attach(const TeXTrieNode* nodes, int node_count, const ushort* edge_chars, const quint32* edge_targets,
+                     const quint8* levels)
+{
+    _nodes = nodes;
+    _node_count = node_count;
+    _edge_chars = edge_chars;
+    _edge_targets = edge_targets;
+    _levels = levels;
+}
+
+bool TeXTrie::load(const QString& file_name)
+{
+    auto file = std::make_shared<QFile>(file_name);
+    if (!file->open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = file->size();
+    const uchar* data = size >= static_cast<qint64>(sizeof(TeXTrieFileHeader)) ? file->map(0, size) : nullptr;
+    if (data == nullptr) {
+        qDebug() << "TeXTrie: invalid file" << file_name;
+        return false;
+    }
+
+    const TeXTrieFileHeader* header = reinterpret_cast<const TeXTrieFileHeader*>(data);
+    const quint32 nodes_offset = align4(sizeof(TeXTrieFileHeader));
+    const quint64 edge_chars_offset = align4(nodes_offset + static_cast<quint64>(header->node_count) * sizeof(TeXTrieNode));
+    const quint64 edge_targets_offset = align4(edge_chars_offset + static_cast<quint64>(header->edge_count) * sizeof(ushort));
+    const quint64 levels_offset = edge_targets_offset + static_cast<quint64>(header->edge_count) * sizeof(quint32);
+    if (memcmp(header->magic, _file_magic, sizeof(_file_magic)) != 0 || header->version != _file_version
+        || header->node_count == 0 || levels_offset + header->level_count > static_cast<quint64>(size)) {
+        qDebug() << "TeXTrie: invalid file" << file_name;
+        return false;
+    }
+
+    // ссылки узлов не должны выходить за пределы таблиц, иначе поиск по поврежденному файлу обратится к чужой памяти
+    const TeXTrieNode* nodes = reinterpret_cast<const TeXTrieNode*>(data + nodes_offset);
+    const quint32* edge_targets = reinterpret_cast<const quint32*>(data + edge_targets_offset);
+    for (quint32 i = 0; i < header->node_count; i++) {
+        const TeXTrieNode& n = nodes[i];
+        if (static_cast<quint64>(n.first_edge) + n.edge_count > header->edge_count
+            || static_cast<quint64>(n.levels_offset) + n.levels_count > header->level_count) {
+            qDebug() << "TeXTrie: invalid file" << file_name;
+            return false;
+        }
+    }
+    for (quint32 i = 0; i < header->edge_count; i++) {
+        if (edge_targets[i] >= header->node_count) {
+            qDebug() << "TeXTrie: invalid file" << file_name;
+            return false;
+        }
+    }
+
+    _node_data.clear();
+    _edge_char_data.clear();
+    _edge_target_data.clear();
+    _level_data.clear();
+    _file = file;
+    attach(nodes, static_cast<int>(header->node_count), reinterpret_cast<const ushort*>(data + edge_chars_offset),
+           edge_targets, data + levels_offset);
+    return true;
+}
+
+bool TeXTrie::save(const QString& file_name) const
+{
+    int edge_count;
+    int level_count;
+    tableSizes(edge_count, level_count);
+
+    TeXTrieFileHeader header;
+    memcpy(header.magic, _file_magic, sizeof(_file_magic));
+    header.version = _file_version;
+    header.node_count = static_cast<quint32>(_node_count);
+    header.edge_count = static_cast<quint32>(edge_count);
+    header.level_count = static_cast<quint32>(level_count);
+
+    const quint32 nodes_offset = align4(sizeof(TeXTrieFileHeader));
+    const quint32 edge_chars_offset = align4(nodes_offset + _node_count * sizeof(TeXTrieNode));
+    const quint32 edge_targets_offset = align4(edge_chars_offset + edge_count * sizeof(ushort));
+    const quint32 levels_offset = edge_targets_offset + edge_count * sizeof(quint32);
+
+    QByteArray data(static_cast<int>(levels_offset) + level_count, 0);
+    memcpy(data.data(), &header, sizeof(header));
+    if (_node_count > 0)
+        memcpy(data.data() + nodes_offset, _nodes, _node_count * sizeof(TeXTrieNode));
+    if (edge_count > 0) {
+        memcpy(data.data() + edge_chars_offset, _edge_chars, edge_count * sizeof(ushort));
+        memcpy(data.data() + edge_targets_offset, _edge_targets, edge_count * sizeof(quint32));
+    }
+    if (level_count > 0)
+        memcpy(data.data() + levels_offset, _levels, level_count);
+
+    QSaveFile file(file_name);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size())
+        return false;
+    return file.commit();
+}
+
+void TeXTrie::tableSizes(int& edge_count, int& level_count) const
+{
+    edge_count = 0;
+    level_count = 0;
+    for (int i = 0; i < _node_count; i++) {
+        edge_count = qMax(edge_count, static_cast<int>(_nodes[i].first_edge + _nodes[i].edge_count));
+        level_count = qMax(level_count, static_cast<int>(_nodes[i].levels_offset + _nodes[i].levels_count));
+    }
+}
+
+bool TeXTrie::isEmpty() const
+{
+    return _node_count == 0;
+}
+
+void TeXTrie::apply(const QChar* word, int size, int start, quint8* levels) const
+{
+    if (_node_count == 0)
+        return;
+
+    int node = 0;
+    for (int i = start; i < size; i++) {
+        node = child(node, word[i].unicode());
+        if (node < 0)
+            return;
+
+        const TeXTrieNode& n = _nodes[node];
+        const int count = qMin(static_cast<int>(n.levels_count), size - start);
+        const quint8* pattern_levels = _levels + n.levels_offset;
+        for (int l = 0; l < count; l++) {
+            if (pattern_levels[l] > levels[start + l])
+                levels[start + l] = pattern_levels[l];
+        }
+    }
+}
+
+int TeXTrie::child(int node, ushort c) const
+{
+    const TeXTrieNode& n = _nodes[node];
+    const ushort* begin = _edge_chars + n.first_edge;
+    const ushort* end = begin + n.edge_count;
+    const ushort* it = std::lower_bound(begin, end, c);
+    if (it == end || *it != c)
+        return -1;
+
+    return static_cast<int>(_edge_targets[it - _edge_chars]);
+}
+} // namespace Hyphenation
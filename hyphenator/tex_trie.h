@@ -0,0 +1,97 @@
+#pragma once
+
+#include "hyphenator_dll.h"
+
+#include <QChar>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+class QFile;
+
+namespace Hyphenation
+{
+//! Узел упакованного дерева шаблонов TeX
+struct TeXTrieNode
+{
+    //! Индекс первого перехода в массивах символов и узлов переходов. Переходы узла отсортированы по символу
+    quint32 first_edge;
+    //! Количество переходов
+    quint32 edge_count;
+    //! Индекс первого уровня шаблона, который заканчивается в этом узле
+    quint32 levels_offset;
+    //! Количество уровней. 0 - в узле не заканчивается ни один шаблон
+    quint32 levels_count;
+};
+
+//! Упакованное префиксное дерево шаблонов TeX. Узлы, переходы и уровни переноса хранятся в плоских массивах, поэтому
+//! поиск всех шаблонов, начинающихся с позиции слова, выполняется за один проход по слову без выделения памяти
+class HYPHENATOR_DLL_API TeXTrie
+{
+public:
+    TeXTrie();
+    //! Построить по шаблонам TeX
+    explicit TeXTrie(const char* const* patterns);
+    //! Использовать заранее построенные таблицы (см. attach)
+    TeXTrie(const TeXTrieNode* nodes, int node_count, const ushort* edge_chars, const quint32* edge_targets,
+            const quint8* levels);
+
+    //! Построить по шаблонам TeX (массив строк utf8, последний элемент - nullptr)
+    void build(const char* const* patterns);
+    //! Построить по шаблонам TeX
+    void build(const QStringList& patterns);
+    //! Загрузить таблицы из двоичного файла (см. save). Файл отображается в память, данные не копируются
+    bool load(const QString& file_name);
+    //! Сохранить таблицы в компактный двоичный файл
+    bool save(const QString& file_name) const;
+    //! Использовать заранее построенные таблицы. Данные не копируются и должны существовать все время жизни объекта
+    void attach(const TeXTrieNode* nodes, int node_count, const ushort* edge_chars, const quint32* edge_targets,
+                const quint8* levels);
+
+    //! Нет шаблонов
+    bool isEmpty() const;
+
+    //! Применить шаблоны, начинающиеся с позиции start слова: уровни переноса levels (по одному на символ слова)
+    //! увеличиваются до уровней найденных шаблонов
+    void apply(const QChar* word, int size, int start, quint8* levels) const;
+
+    //! Упакованные таблицы (для генерации таблиц на этапе сборки)
+    const QVector<TeXTrieNode>& nodeData() const { return _node_data; }
+    const QVector<ushort>& edgeCharData() const { return _edge_char_data; }
+    const QVector<quint32>& edgeTargetData() const { return _edge_target_data; }
+    const QVector<quint8>& levelData() const { return _level_data; }
+
+private:
+    Q_DISABLE_COPY(TeXTrie)
+
+    //! Переход из узла по символу. -1, если перехода нет
+    int child(int node, ushort c) const;
+    //! Количество переходов и уровней по таблице узлов
+    void tableSizes(int& edge_count, int& level_count) const;
+
+    //! Файл, отображенный в память (load)
+    std::shared_ptr<QFile> _file;
+
+    // Данные, если дерево построено в build
+    QVector<TeXTrieNode> _node_data;
+    QVector<ushort> _edge_char_data;
+    QVector<quint32> _edge_target_data;
+    QVector<quint8> _level_data;
+
+    // Таблицы, по которым идет поиск
+    const TeXTrieNode* _nodes = nullptr;
+    int _node_count = 0;
+    const ushort* _edge_chars = nullptr;
+    const quint32* _edge_targets = nullptr;
+    const quint8* _levels = nullptr;
+};
+
+#ifdef HYPHENATOR_GENERATED_PATTERNS
+//! Таблицы, построенные tools/tex_trie_gen на этапе сборки
+extern const TeXTrieNode tex_trie_nodes[];
+extern const int tex_trie_node_count;
+extern const ushort tex_trie_edge_chars[];
+extern const quint32 tex_trie_edge_targets[];
+extern const quint8 tex_trie_levels[];
+#endif
+} // namespace Hyphenation
@@ -1,4 +1,5 @@
 #include "texthyphenationformatter.h"
+#include "hyphenationlanguages.h"
 
 #include <QCryptographicHash>
 #include <QDebug>
@@ -82,7 +83,7 @@ QStringList TextHyphenationFormatter::splitHelper(const QString& text, int width
     QString line;
     QString tempRest;
     QString leftPart, rightPart;
-    QStringList hyphenation;
+    HyphenBreaks hyphenation;
 
     while (!restText.isEmpty()) {
         // Т.к. width/fontMetrics.averageCharWidth() дает лишь примерную длину максимальной строки текста в линии,
@@ -176,22 +177,28 @@ QStringList TextHyphenationFormatter::splitHelper(const QString& text, int width
             }
 
             // Разбиваем на слоги
-            hyphenation = _hyphenator->doHyphenate(word);
-            // Получаем строку слева, за исключением невлезающего слова
+            hyphenation.clear();
+            _hyphenator->doHyphenateBreaks(word, hyphenation);
+            // Получаем строку слева, за исключением невлезающего слова. Слоги дописываются в нее же, без создания
+            // промежуточных строк
             leftText = line.mid(0, leftPos);
+            leftText.reserve(leftPos + word.length() + 1);
             // Ищем какой слог влезает в остатки линии
             bool isCanSplit = false;
             bool isSplitChar = false;
-            for (int i = 0; i < hyphenation.count(); i++) {
-                QString tempPart;
-                bool tempSplitChar = false;
+            int syllableStart = 0;
+            for (int i = 0; i <= hyphenation.count(); i++) {
+                int syllableEnd = (i < hyphenation.count()) ? hyphenation.at(i) : word.length();
+                if (syllableEnd <= syllableStart)
+                    continue;
+
+                int leftLength = leftText.length();
+                leftText.append(word.constData() + syllableStart, syllableEnd - syllableStart);
                 // Проверяем нет ли дефиса на конце слога
-                if (hyphenation.at(i).at(hyphenation.at(i).count() - 1) == '-') {
-                    tempPart = hyphenation.at(i);
-                    tempSplitChar = true;
-                } else {
-                    tempPart = hyphenation.at(i) + '-';
-                }
+                bool tempSplitChar = word.at(syllableEnd - 1) == '-';
+                if (!tempSplitChar)
+                    leftText.append('-');
+
                 // Замеряем влезает ли
                 if (fontMetrics.
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
@@ -199,11 +206,15 @@ QStringList TextHyphenationFormatter::splitHelper(const QString& text, int width
 #else
                     width
 #endif
-                    (leftText + tempPart)
+                    (leftText)
                     > width) {
+                    leftText.truncate(leftLength);
                     break;
                 }
-                leftText += hyphenation.at(i);
+                if (!tempSplitChar)
+                    leftText.chop(1);
+
+                syllableStart = syllableEnd;
                 isSplitChar = tempSplitChar;
                 isCanSplit = true;
             }
@@ -268,16 +279,23 @@ const QStringList TextHyphenationFormatter::split(const QString& text, int width
     }
 
     QString key = generateHasgString(text);
-    SplitInfo* si = _splitCache.object(key);
-    if (si && si->width == width)
-        return si->split;
+    {
+        QMutexLocker lock(&_splitCacheMutex);
+        SplitInfo* si = _splitCache.object(key);
+        if (si && si->width == width)
+            return si->split;
+    }
 
-    si = new SplitInfo;
+    // разбиение выполняется без блокировки, чтобы потоки не ждали друг друга
+    QStringList split = splitHelper(text, width, fontMetrics, average_char_width, wrapMode);
+
+    SplitInfo* si = new SplitInfo;
     si->width = width;
-    si->split = splitHelper(text, width, fontMetrics, average_char_width, wrapMode);
-    Q_ASSERT(_splitCache.insert(key, si));
+    si->split = split;
+    QMutexLocker lock(&_splitCacheMutex);
+    _splitCache.insert(key, si);
 
-    return si->split;
+    return split;
 }
 
 void TextHyphenationFormatter::draw(QPainter& p, const QPoint& pos, const QString& text, int width, int leading,
@@ -420,25 +438,18 @@ QRect TextHyphenationFormatter::boundingRect(
     return res;
 }
 
-TextHyphenationFormatter* GlobalTextHyphenationFormatter::_textHyphenationFormatter = nullptr;
-GlobalTextHyphenationFormatter::Initializer GlobalTextHyphenationFormatter::_initializer;
-
-GlobalTextHyphenationFormatter::Initializer::Initializer()
+//! Глобальный объект форматирования. Объявлен после механизма разбиения, поэтому удаляется раньше него
+struct GlobalTextHyphenationFormatterData
 {
-}
-
-GlobalTextHyphenationFormatter::Initializer::~Initializer()
-{
-    //    if (GlobalTextHyphenationFormatter::_textHyphenationFormatter)
-    //        delete GlobalTextHyphenationFormatter::_textHyphenationFormatter;
-}
+    MultiLanguageHyphenator hyphenator;
+    TextHyphenationFormatter formatter {&hyphenator};
+};
 
 TextHyphenationFormatter* GlobalTextHyphenationFormatter::formatter()
 {
-    if (!_textHyphenationFormatter)
-        _textHyphenationFormatter = new TextHyphenationFormatter(GlobalHyphenationHash::hash());
-
-    return _textHyphenationFormatter;
+    // инициализация локальной статической переменной потокобезопасна
+    static GlobalTextHyphenationFormatterData data;
+    return &data.formatter;
 }
 
 QString GlobalTextHyphenationFormatter::stringToMultiline(const QFontMetrics& fm, const QString& value, int width)
@@ -5,11 +5,14 @@
 
 #include <QCache>
 #include <QFontMetrics>
+#include <QMutex>
 #include <QPainter>
 
 namespace Hyphenation
 {
 //! Разбиение строки текста на линии по правилам переноса русского и английского языка
+//! split и boundingRect потокобезопасны и могут вызываться вне потока GUI (кэш разбитых строк защищен блокировкой),
+//! если потокобезопасен используемый Hyphenator
 class HYPHENATOR_DLL_API TextHyphenationFormatter
 {
 public:
@@ -74,30 +77,18 @@ private:
         QStringList split;
     };
     QCache<QString, SplitInfo> _splitCache;
+    QMutex _splitCacheMutex;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(TextHyphenationFormatter::WrapFlags)
 
 //! Статический класс с глобальным объектом TextHyphenationFormatter
+//! Объект создается потокобезопасно при первом обращении и удаляется при завершении программы
 class HYPHENATOR_DLL_API GlobalTextHyphenationFormatter
 {
-    //! Внутренний класс-инициализатор статических переменных в GlobalTextHyphenationFormatter
-    class Initializer
-    {
-    public:
-        Initializer();
-        ~Initializer();
-    };
-
-    friend class Initializer;
-
 public:
     static TextHyphenationFormatter* formatter();
     static QString stringToMultiline(const QFontMetrics& fm, const QString& value, int width);
-
-private:
-    static TextHyphenationFormatter* _textHyphenationFormatter;
-    static Initializer _initializer;
 };
 } // namespace Hyphenation
 
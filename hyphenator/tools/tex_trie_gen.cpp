@@ -0,0 +1,99 @@
+//! Генератор упакованного дерева шаблонов TeX на этапе сборки
+//! Использование: tex_trie_gen <выходной файл .cpp|.bin> [файл шаблонов]
+//! Таблицы попадают в read-only данные библиотеки, поэтому первое разбиение на слоги не требует разбора шаблонов и
+//! таблицы разделяются между процессами
+//! Если выходной файл .bin, то таблицы сохраняются в двоичный файл для HyphenationLanguages::registerPatternFile.
+//! Файл шаблонов - текст в utf8, по одному шаблону TeX в строке. Если не задан, то используются русские шаблоны
+
+#include "tex_patterns.h"
+#include "tex_trie.h"
+
+#include <QFile>
+#include <QTextStream>
+
+#include <cstdio>
+
+using namespace Hyphenation;
+
+//! Вывести массив чисел по 16 значений в строке
+template <typename T>
+static void writeArray(QTextStream& out, const char* type, const char* name, const QVector<T>& data)
+{
+    out << "extern const " << type << " " << name << "[] = {";
+    for (int i = 0; i < data.count(); i++) {
+        if (i % 16 == 0)
+            out << "\n    ";
+        out << static_cast<quint32>(data.at(i)) << ",";
+    }
+    // пустой массив недопустим
+    if (data.isEmpty())
+        out << "0";
+    out << "\n};\n\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: tex_trie_gen <output.cpp|output.bin> [patterns.txt]\n");
+        return 1;
+    }
+
+    TeXTrie trie;
+    if (argc > 2) {
+        QFile source(QString::fromLocal8Bit(argv[2]));
+        if (!source.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            fprintf(stderr, "tex_trie_gen: can't open %s\n", argv[2]);
+            return 1;
+        }
+
+        QStringList source_patterns;
+        for (const QByteArray& line : source.readAll().split('\n')) {
+            QString pattern = QString::fromUtf8(line).trimmed();
+            if (!pattern.isEmpty() && !pattern.startsWith('%'))
+                source_patterns << pattern;
+        }
+        trie.build(source_patterns);
+
+    } else {
+        trie.build(patterns);
+    }
+
+    const QString output = QString::fromLocal8Bit(argv[1]);
+    if (output.endsWith(QStringLiteral(".bin"), Qt::CaseInsensitive)) {
+        if (!trie.save(output)) {
+            fprintf(stderr, "tex_trie_gen: can't write %s\n", argv[1]);
+            return 1;
+        }
+        return 0;
+    }
+
+    QFile file(output);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        fprintf(stderr, "tex_trie_gen: can't open %s\n", argv[1]);
+        return 1;
+    }
+
+    QTextStream out(&file);
+    // только ASCII, чтобы не зависеть от кодировки QTextStream по умолчанию в Qt5
+    out << "// Generated by tex_trie_gen from tex_patterns.cpp. Do not edit\n\n";
+    out << "#include \"tex_trie.h\"\n\n";
+    out << "namespace Hyphenation\n{\n";
+
+    out << "extern const TeXTrieNode tex_trie_nodes[] = {";
+    const QVector<TeXTrieNode>& nodes = trie.nodeData();
+    for (int i = 0; i < nodes.count(); i++) {
+        const TeXTrieNode& n = nodes.at(i);
+        out << "\n    {" << n.first_edge << ", " << n.edge_count << ", " << n.levels_offset << ", " << n.levels_count << "},";
+    }
+    out << "\n};\n\n";
+    out << "extern const int tex_trie_node_count = " << nodes.count() << ";\n\n";
+
+    writeArray(out, "ushort", "tex_trie_edge_chars", trie.edgeCharData());
+    writeArray(out, "quint32", "tex_trie_edge_targets", trie.edgeTargetData());
+    writeArray(out, "quint8", "tex_trie_levels", trie.levelData());
+
+    out << "} // namespace Hyphenation\n";
+    out.flush();
+
+    return file.error() == QFile::NoError ? 0 : 1;
+}
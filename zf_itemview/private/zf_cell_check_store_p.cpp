@@ -0,0 +1,483 @@
+#include "zf_cell_check_store_p.h"
+
+#include <QAbstractItemModel>
+
+namespace zf
+{
+CellCheckStore::CellCheckStore(QObject* parent)
+    : QObject(parent)
+{
+}
+
+bool CellCheckStore::isChecked(const QModelIndex& index) const
+{
+    Q_ASSERT(index.isValid());
+
+    if (index.model() != _model)
+        return false;
+
+    if (isFlat(index)) {
+        auto flat = _flat.constFind(index.column());
+        return flat != _flat.constEnd() && testBit(*flat, index.row());
+    }
+
+    if (_tree.isEmpty())
+        return false;
+
+    auto columns = _tree.constFind(QPersistentModelIndex(index.sibling(index.row(), 0)));
+    return columns != _tree.constEnd() && columns->contains(index.column());
+}
+
+bool CellCheckStore::setChecked(const QModelIndex& index, bool checked)
+{
+    Q_ASSERT(index.isValid());
+
+    if (index.model() != _model)
+        setModel(index.model());
+
+    if (isFlat(index)) {
+        auto flat = _flat.find(index.column());
+        if (flat == _flat.end()) {
+            if (!checked)
+                return false;
+            flat = _flat.insert(index.column(), FlatColumn());
+        }
+
+        if (index.row() >= flat->size) {
+            if (!checked)
+                return false;
+            resizeBits(*flat, qMax(_model->rowCount(), index.row() + 1));
+        }
+
+        if (testBit(*flat, index.row()) == checked)
+            return false;
+
+        setBit(*flat, index.row(), checked);
+        flat->count += checked ? 1 : -1;
+        Q_ASSERT(flat->count >= 0);
+        if (flat->count == 0)
+            _flat.erase(flat);
+        return true;
+    }
+
+    QPersistentModelIndex row_index(index.sibling(index.row(), 0));
+    auto columns = _tree.find(row_index);
+    if (checked) {
+        if (columns == _tree.end())
+            columns = _tree.insert(row_index, QSet<int>());
+        if (columns->contains(index.column()))
+            return false;
+        columns->insert(index.column());
+        return true;
+    }
+
+    if (columns == _tree.end() || !columns->remove(index.column()))
+        return false;
+    if (columns->isEmpty())
+        _tree.erase(columns);
+    return true;
+}
+
+int CellCheckStore::setChecked(
+    const QAbstractItemModel* model, const QModelIndex& parent, int first_row, int last_row, int first_column, int last_column, bool checked)
+{
+    Q_ASSERT(model != nullptr);
+    Q_ASSERT(!parent.isValid() || parent.model() == model);
+
+    first_row = qMax(0, first_row);
+    last_row = qMin(model->rowCount(parent) - 1, last_row);
+    first_column = qMax(0, first_column);
+    last_column = qMin(model->columnCount(parent) - 1, last_column);
+    if (first_row > last_row || first_column > last_column)
+        return 0;
+
+    if (model != _model)
+        setModel(model);
+
+    int changed = 0;
+    if (!parent.isValid()) {
+        // верхний уровень: меняем биты без создания индексов
+        for (int column = first_column; column <= last_column; column++) {
+            auto flat = _flat.find(column);
+            if (flat == _flat.end()) {
+                if (!checked)
+                    continue;
+                flat = _flat.insert(column, FlatColumn());
+            }
+            if (flat->size <= last_row) {
+                if (!checked && flat->size <= first_row)
+                    continue;
+                if (checked)
+                    resizeBits(*flat, qMax(model->rowCount(), last_row + 1));
+            }
+
+            int column_changed = 0;
+            for (int row = first_row; row <= qMin(last_row, flat->size - 1); row++) {
+                if (testBit(*flat, row) == checked)
+                    continue;
+                setBit(*flat, row, checked);
+                column_changed++;
+            }
+            changed += column_changed;
+
+            flat->count += checked ? column_changed : -column_changed;
+            Q_ASSERT(flat->count >= 0);
+            if (flat->count == 0)
+                _flat.erase(flat);
+        }
+
+    } else {
+        for (int row = first_row; row <= last_row; row++) {
+            for (int column = first_column; column <= last_column; column++) {
+                if (setChecked(model->index(row, column, parent), checked))
+                    changed++;
+            }
+        }
+    }
+
+    return changed;
+}
+
+QModelIndexList CellCheckStore::checkedCells() const
+{
+    QModelIndexList res;
+    if (_model == nullptr)
+        return res;
+
+    for (auto i = _flat.constBegin(); i != _flat.constEnd(); ++i) {
+        const int row_count = qMin(i->size, _model->rowCount());
+        for (int row = 0; row < row_count; row++) {
+            if (testBit(*i, row))
+                res << _model->index(row, i.key());
+        }
+    }
+
+    for (auto i = _tree.constBegin(); i != _tree.constEnd(); ++i) {
+        if (!i.key().isValid())
+            continue;
+
+        for (int column : i.value()) {
+            res << i.key().sibling(i.key().row(), column);
+        }
+    }
+
+    return res;
+}
+
+bool CellCheckStore::isEmpty() const
+{
+    return _flat.isEmpty() && _tree.isEmpty();
+}
+
+void CellCheckStore::clear()
+{
+    _flat.clear();
+    _tree.clear();
+    _layout_snapshot.clear();
+}
+
+void CellCheckStore::sl_rowsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid())
+        return;
+
+    for (auto& flat : _flat) {
+        if (first < flat.size)
+            insertBits(flat, first, last - first + 1);
+    }
+}
+
+void CellCheckStore::sl_rowsRemoved(const QModelIndex& parent, int first, int last)
+{
+    if (!parent.isValid()) {
+        for (auto i = _flat.begin(); i != _flat.end();) {
+            if (first < i->size)
+                i->count -= removeBits(*i, first, qMin(last, i->size - 1) - first + 1);
+
+            Q_ASSERT(i->count >= 0);
+            if (i->count == 0)
+                i = _flat.erase(i);
+            else
+                ++i;
+        }
+    }
+
+    // вложенных строк нет (в т.ч. в плоской модели)
+    if (_tree.isEmpty())
+        return;
+
+    // индексы удаленных строк (в т.ч. дочерних) стали невалидными
+    for (auto i = _tree.begin(); i != _tree.end();) {
+        if (i.key().isValid())
+            ++i;
+        else
+            i = _tree.erase(i);
+    }
+}
+
+void CellCheckStore::sl_columnsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid())
+        return;
+
+    const int count = last - first + 1;
+
+    QHash<int, FlatColumn> flat;
+    for (auto i = _flat.constBegin(); i != _flat.constEnd(); ++i) {
+        flat.insert(i.key() >= first ? i.key() + count : i.key(), i.value());
+    }
+    _flat = flat;
+
+    for (auto& columns : _tree) {
+        QSet<int> shifted;
+        for (int column : qAsConst(columns)) {
+            shifted << (column >= first ? column + count : column);
+        }
+        columns = shifted;
+    }
+}
+
+void CellCheckStore::sl_columnsRemoved(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid())
+        return;
+
+    const int count = last - first + 1;
+
+    QHash<int, FlatColumn> flat;
+    for (auto i = _flat.constBegin(); i != _flat.constEnd(); ++i) {
+        if (i.key() < first)
+            flat.insert(i.key(), i.value());
+        else if (i.key() > last)
+            flat.insert(i.key() - count, i.value());
+    }
+    _flat = flat;
+
+    for (auto i = _tree.begin(); i != _tree.end();) {
+        QSet<int> shifted;
+        for (int column : qAsConst(i.value())) {
+            if (column < first)
+                shifted << column;
+            else if (column > last)
+                shifted << column - count;
+        }
+
+        if (shifted.isEmpty()) {
+            i = _tree.erase(i);
+        } else {
+            i.value() = shifted;
+            ++i;
+        }
+    }
+}
+
+void CellCheckStore::sl_columnsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int column)
+{
+    if (parent.isValid() || destination.isValid())
+        return;
+
+    QHash<int, FlatColumn> flat;
+    for (auto i = _flat.constBegin(); i != _flat.constEnd(); ++i) {
+        flat.insert(movedPosition(i.key(), start, end, column), i.value());
+    }
+    _flat = flat;
+
+    for (auto& columns : _tree) {
+        QSet<int> moved;
+        for (int c : qAsConst(columns)) {
+            moved << movedPosition(c, start, end, column);
+        }
+        columns = moved;
+    }
+}
+
+void CellCheckStore::sl_beforeLayoutChanged()
+{
+    // номера строк изменятся, поэтому на время смены порядка запоминаем ячейки верхнего уровня через QPersistentModelIndex
+    _layout_snapshot.clear();
+    if (_model == nullptr)
+        return;
+
+    const int row_count = _model->rowCount();
+    for (auto i = _flat.constBegin(); i != _flat.constEnd(); ++i) {
+        for (int row = 0; row < qMin(row_count, i->size); row++) {
+            if (testBit(*i, row))
+                _layout_snapshot << QPersistentModelIndex(_model->index(row, i.key()));
+        }
+    }
+    _flat.clear();
+}
+
+void CellCheckStore::sl_afterLayoutChanged()
+{
+    auto snapshot = _layout_snapshot;
+    _layout_snapshot.clear();
+
+    for (auto& index : qAsConst(snapshot)) {
+        if (index.isValid())
+            setChecked(index, true);
+    }
+
+    // вложенные строки могли переместиться на верхний уровень
+    for (auto i = _tree.begin(); i != _tree.end();) {
+        if (!i.key().isValid()) {
+            i = _tree.erase(i);
+
+        } else if (!i.key().parent().isValid()) {
+            QPersistentModelIndex row_index = i.key();
+            QSet<int> columns = i.value();
+            i = _tree.erase(i);
+            for (int column : qAsConst(columns)) {
+                setChecked(row_index.sibling(row_index.row(), column), true);
+            }
+
+        } else {
+            ++i;
+        }
+    }
+}
+
+void CellCheckStore::setModel(const QAbstractItemModel* model)
+{
+    if (_model != nullptr)
+        disconnect(_model, nullptr, this, nullptr);
+
+    clear();
+    _model = const_cast<QAbstractItemModel*>(model);
+    if (_model == nullptr)
+        return;
+
+    connect(_model, &QAbstractItemModel::rowsInserted, this, &CellCheckStore::sl_rowsInserted);
+    connect(_model, &QAbstractItemModel::rowsRemoved, this, &CellCheckStore::sl_rowsRemoved);
+    connect(_model, &QAbstractItemModel::columnsInserted, this, &CellCheckStore::sl_columnsInserted);
+    connect(_model, &QAbstractItemModel::columnsRemoved, this, &CellCheckStore::sl_columnsRemoved);
+    connect(_model, &QAbstractItemModel::columnsMoved, this, &CellCheckStore::sl_columnsMoved);
+    connect(_model, &QAbstractItemModel::rowsAboutToBeMoved, this, &CellCheckStore::sl_beforeLayoutChanged);
+    connect(_model, &QAbstractItemModel::rowsMoved, this, &CellCheckStore::sl_afterLayoutChanged);
+    connect(_model, &QAbstractItemModel::layoutAboutToBeChanged, this, &CellCheckStore::sl_beforeLayoutChanged);
+    connect(_model, &QAbstractItemModel::layoutChanged, this, &CellCheckStore::sl_afterLayoutChanged);
+    connect(_model, &QAbstractItemModel::modelReset, this, &CellCheckStore::clear);
+}
+
+bool CellCheckStore::isFlat(const QModelIndex& index)
+{
+    return !index.parent().isValid();
+}
+
+bool CellCheckStore::testBit(const FlatColumn& column, int pos)
+{
+    return pos >= 0 && pos < column.size && (column.words.at(pos >> 6) >> (pos & 63)) & 1;
+}
+
+void CellCheckStore::setBit(FlatColumn& column, int pos, bool value)
+{
+    Q_ASSERT(pos >= 0 && pos < column.size);
+
+    const quint64 mask = quint64(1) << (pos & 63);
+    if (value)
+        column.words[pos >> 6] |= mask;
+    else
+        column.words[pos >> 6] &= ~mask;
+}
+
+void CellCheckStore::resizeBits(FlatColumn& column, int size)
+{
+    Q_ASSERT(size >= 0);
+
+    column.words.resize((size + 63) >> 6);
+    column.size = size;
+
+    // обнуляем хвост последнего слова при уменьшении
+    if ((size & 63) != 0)
+        column.words.last() &= (quint64(1) << (size & 63)) - 1;
+}
+
+void CellCheckStore::insertBits(FlatColumn& column, int pos, int count)
+{
+    Q_ASSERT(pos >= 0 && pos <= column.size && count > 0);
+
+    const int old_size = column.size;
+    resizeBits(column, old_size + count);
+
+    // биты с pos сдвигаются словами от конца, чтобы не затереть еще не прочитанные
+    for (int src = pos + ((old_size - pos - 1) & ~63); src >= pos; src -= 64) {
+        writeWord(column.words, src + count, readWord(column.words, src));
+    }
+
+    // освободившийся диапазон обнуляется
+    for (int p = pos; p < pos + count; p += 64) {
+        const int n = qMin(64, pos + count - p);
+        writeWord(column.words, p, n == 64 ? 0 : readWord(column.words, p) & ~((quint64(1) << n) - 1));
+    }
+}
+
+int CellCheckStore::removeBits(FlatColumn& column, int pos, int count)
+{
+    Q_ASSERT(pos >= 0 && count > 0 && pos + count <= column.size);
+
+    int removed = 0;
+    for (int p = pos; p < pos + count; p += 64) {
+        const int n = qMin(64, pos + count - p);
+        quint64 word = readWord(column.words, p);
+        if (n < 64)
+            word &= (quint64(1) << n) - 1;
+        removed += static_cast<int>(qPopulationCount(word));
+    }
+
+    // биты после удаленного диапазона сдвигаются словами от начала
+    for (int src = pos + count; src < column.size; src += 64) {
+        writeWord(column.words, src - count, readWord(column.words, src));
+    }
+
+    resizeBits(column, column.size - count);
+    return removed;
+}
+
+quint64 CellCheckStore::readWord(const QVector<quint64>& words, int pos)
+{
+    const int i = pos >> 6;
+    const int shift = pos & 63;
+    if (i >= words.count())
+        return 0;
+
+    quint64 value = words.at(i) >> shift;
+    if (shift != 0 && i + 1 < words.count())
+        value |= words.at(i + 1) << (64 - shift);
+    return value;
+}
+
+void CellCheckStore::writeWord(QVector<quint64>& words, int pos, quint64 value)
+{
+    const int i = pos >> 6;
+    const int shift = pos & 63;
+    if (i >= words.count())
+        return;
+
+    if (shift == 0) {
+        words[i] = value;
+        return;
+    }
+
+    const quint64 low_mask = (quint64(1) << shift) - 1;
+    words[i] = (words.at(i) & low_mask) | (value << shift);
+    if (i + 1 < words.count())
+        words[i + 1] = (words.at(i + 1) & ~low_mask) | (value >> (64 - shift));
+}
+
+int CellCheckStore::movedPosition(int pos, int start, int end, int destination)
+{
+    const int count = end - start + 1;
+
+    if (pos >= start && pos <= end)
+        return destination > end ? pos - start + destination - count : pos - start + destination;
+
+    if (destination > end && pos > end && pos < destination)
+        return pos - count;
+
+    if (destination < start && pos >= destination && pos < start)
+        return pos + count;
+
+    return pos;
+}
+
+} // namespace zf
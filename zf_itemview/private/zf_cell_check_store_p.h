@@ -0,0 +1,95 @@
+#pragma once
+
+#include <QHash>
+#include <QModelIndexList>
+#include <QPersistentModelIndex>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
+
+class QAbstractItemModel;
+
+namespace zf
+{
+/*! Хранилище состояния чекбоксов ячеек. Работает с индексами source модели.
+ * Ячейки строк верхнего уровня хранятся в битовых массивах по колонкам (номер бита - номер строки), ячейки вложенных
+ * строк - в хэше по QPersistentModelIndex строки. Поиск за O(1). Вставка и удаление строк сдвигают биты словами по 64 */
+class CellCheckStore : public QObject
+{
+    Q_OBJECT
+public:
+    CellCheckStore(QObject* parent = nullptr);
+
+    //! Состояние чекбокса ячейки
+    bool isChecked(const QModelIndex& index) const;
+    //! Задать состояние чекбокса ячейки. Возвращает истину, если состояние изменилось
+    bool setChecked(const QModelIndex& index, bool checked);
+    //! Задать состояние чекбоксов диапазона ячеек одного родителя. Возвращает количество измененных ячеек
+    int setChecked(const QAbstractItemModel* model, const QModelIndex& parent, int first_row, int last_row, int first_column,
+        int last_column, bool checked);
+
+    //! Все выделенные ячейки
+    QModelIndexList checkedCells() const;
+    //! Есть ли выделенные ячейки
+    bool isEmpty() const;
+    //! Очистить
+    void clear();
+
+private slots:
+    void sl_rowsInserted(const QModelIndex& parent, int first, int last);
+    void sl_rowsRemoved(const QModelIndex& parent, int first, int last);
+    void sl_columnsInserted(const QModelIndex& parent, int first, int last);
+    void sl_columnsRemoved(const QModelIndex& parent, int first, int last);
+    void sl_columnsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int column);
+    //! Перед перемещением строк или сменой порядка
+    void sl_beforeLayoutChanged();
+    //! После перемещения строк или смены порядка
+    void sl_afterLayoutChanged();
+
+private:
+    //! Подключиться к модели
+    void setModel(const QAbstractItemModel* model);
+    //! Строки верхнего уровня хранятся в битовых массивах
+    static bool isFlat(const QModelIndex& index);
+
+    struct FlatColumn;
+
+    //! Состояние бита
+    static bool testBit(const FlatColumn& column, int pos);
+    //! Задать состояние бита. Бит должен быть в пределах размера
+    static void setBit(FlatColumn& column, int pos, bool value);
+    //! Изменить количество битов. Новые биты нулевые
+    static void resizeBits(FlatColumn& column, int size);
+    //! Вставить count нулевых битов в позицию pos
+    static void insertBits(FlatColumn& column, int pos, int count);
+    //! Удалить count битов с позиции pos. Возвращает количество удаленных установленных битов
+    static int removeBits(FlatColumn& column, int pos, int count);
+    //! 64 бита, начиная с pos. Биты за пределами массива нулевые
+    static quint64 readWord(const QVector<quint64>& words, int pos);
+    //! Записать 64 бита, начиная с pos. Биты за пределами массива отбрасываются
+    static void writeWord(QVector<quint64>& words, int pos, quint64 value);
+    //! Новое положение элемента pos после перемещения элементов start-end перед destination
+    static int movedPosition(int pos, int start, int end, int destination);
+
+    QPointer<QAbstractItemModel> _model;
+
+    //! Ячейки строк верхнего уровня одной колонки
+    struct FlatColumn
+    {
+        //! Биты по 64 в слове, номер бита - строка. Биты за пределами size всегда нулевые
+        QVector<quint64> words;
+        //! Количество битов
+        int size = 0;
+        //! Количество выделенных ячеек. Колонка без выделенных ячеек удаляется
+        int count = 0;
+    };
+    //! Ячейки строк верхнего уровня. Ключ - колонка
+    QHash<int, FlatColumn> _flat;
+    //! Ячейки вложенных строк. Ключ - индекс строки (колонка 0), значение - колонки
+    QHash<QPersistentModelIndex, QSet<int>> _tree;
+
+    //! Ячейки верхнего уровня на время смены порядка строк
+    QList<QPersistentModelIndex> _layout_snapshot;
+};
+
+} // namespace zf
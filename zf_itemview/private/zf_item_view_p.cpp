@@ -145,6 +145,11 @@ void FrozenTableView::paintEvent(QPaintEvent* event)
     TableViewBase::paintEvent(event);
 }
 
+bool FrozenTableView::isRowMetricsOwner() const
+{
+    return false;
+}
+
 void FrozenTableView::init()
 {
     Q_ASSERT(_base != nullptr);
@@ -155,9 +160,8 @@ void FrozenTableView::init()
     // т.к. сигнал изначально определен в интерфейсе и у него нет Q_OBJECT, синтаксис Qt5 не подходит
     connect(_base, SIGNAL(sg_checkedCellChanged(QModelIndex, bool)), this, SIGNAL(sg_checkedCellChanged(QModelIndex, bool)));
 
-    connect(verticalHeader(), &QHeaderView::sectionResized, this, [&]() { requestResizeRowsToContents(); });
-
-    requestResizeRowsToContents();
+    // высота строк синхронизируется с основной таблицей через TableView
+    _row_metrics = _base->_row_metrics;
 }
 
 } // namespace zf
@@ -102,6 +102,9 @@ protected:
 
     void paintEvent(QPaintEvent* event) override;
 
+    //! Высоту строк рассчитывает основная таблица, т.к. у нее больше колонок. Фиксированная таблица только читает ее кэш
+    bool isRowMetricsOwner() const override;
+
 private:
     void init();
 
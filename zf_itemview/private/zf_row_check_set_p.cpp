@@ -0,0 +1,201 @@
+#include "zf_row_check_set_p.h"
+
+#include <algorithm>
+
+namespace zf
+{
+RowCheckSet::RowCheckSet()
+{
+}
+
+void RowCheckSet::clear(bool all_checked)
+{
+    _runs.clear();
+    _inverted = all_checked;
+}
+
+bool RowCheckSet::contains(int row) const
+{
+    int i = lowerRun(row);
+    bool in_runs = i < _runs.count() && _runs.at(i).first <= row;
+    return in_runs != _inverted;
+}
+
+bool RowCheckSet::isAllChecked() const
+{
+    return _inverted && _runs.isEmpty();
+}
+
+bool RowCheckSet::hasChecked() const
+{
+    return _inverted || !_runs.isEmpty();
+}
+
+bool RowCheckSet::isInverted() const
+{
+    return _inverted;
+}
+
+bool RowCheckSet::setChecked(int first, int last, bool checked)
+{
+    Q_ASSERT(first >= 0 && last >= first);
+
+    if (checked != _inverted) {
+        // проверяем, что диапазон не содержится в интервалах целиком
+        int i = lowerRun(first);
+        if (i < _runs.count() && _runs.at(i).first <= first && _runs.at(i).last >= last)
+            return false;
+
+        addRange(first, last);
+        return true;
+    }
+
+    return removeRange(first, last);
+}
+
+void RowCheckSet::insertRows(int first, int count)
+{
+    Q_ASSERT(first >= 0 && count > 0);
+
+    int i = lowerRun(first);
+    if (i == _runs.count())
+        return;
+
+    if (_runs.at(i).first < first) {
+        // вставка внутрь интервала: делим его на два
+        Run tail {first + count, _runs.at(i).last + count};
+        _runs[i].last = first - 1;
+        _runs.insert(i + 1, tail);
+        i += 2;
+    }
+
+    for (; i < _runs.count(); i++) {
+        _runs[i].first += count;
+        _runs[i].last += count;
+    }
+}
+
+void RowCheckSet::removeRows(int first, int count)
+{
+    Q_ASSERT(first >= 0 && count > 0);
+
+    removeRange(first, first + count - 1);
+
+    int i = lowerRun(first);
+    for (int j = i; j < _runs.count(); j++) {
+        _runs[j].first -= count;
+        _runs[j].last -= count;
+    }
+
+    // интервалы по краям удаленного диапазона могли стать соседними
+    if (i > 0 && i < _runs.count() && _runs.at(i - 1).last + 1 == _runs.at(i).first) {
+        _runs[i - 1].last = _runs.at(i).last;
+        _runs.remove(i);
+    }
+}
+
+void RowCheckSet::moveRows(int start, int end, int destination)
+{
+    Q_ASSERT(start >= 0 && end >= start);
+
+    if (destination >= start && destination <= end + 1)
+        return;
+
+    const int count = end - start + 1;
+
+    // интервалы перемещаемых строк относительно start
+    QVector<Run> moved;
+    for (int i = lowerRun(start); i < _runs.count() && _runs.at(i).first <= end; i++) {
+        moved << Run {qMax(start, _runs.at(i).first) - start, qMin(end, _runs.at(i).last) - start};
+    }
+
+    removeRows(start, count);
+
+    const int position = destination > end ? destination - count : destination;
+    insertRows(position, count);
+
+    for (auto& run : qAsConst(moved)) {
+        addRange(run.first + position, run.last + position);
+    }
+}
+
+bool RowCheckSet::normalize(int row_count)
+{
+    if (!_inverted || row_count <= 0 || _runs.count() != 1 || _runs.first().first > 0 || _runs.first().last < row_count - 1)
+        return false;
+
+    clear(false);
+    return true;
+}
+
+QSet<int> RowCheckSet::toSet() const
+{
+    Q_ASSERT(!_inverted);
+
+    QSet<int> res;
+    for (auto& run : _runs) {
+        for (int row = run.first; row <= run.last; row++) {
+            res << row;
+        }
+    }
+
+    return res;
+}
+
+void RowCheckSet::addRange(int first, int last)
+{
+    // интервалы, которые пересекаются или соседствуют с добавляемым, поглощаются
+    int i = lowerRun(first > 0 ? first - 1 : 0);
+    int j = i;
+    while (j < _runs.count() && _runs.at(j).first <= last + 1) {
+        first = qMin(first, _runs.at(j).first);
+        last = qMax(last, _runs.at(j).last);
+        j++;
+    }
+
+    if (j > i) {
+        _runs[i] = Run {first, last};
+        _runs.remove(i + 1, j - i - 1);
+    } else {
+        _runs.insert(i, Run {first, last});
+    }
+}
+
+bool RowCheckSet::removeRange(int first, int last)
+{
+    int i = lowerRun(first);
+    if (i == _runs.count() || _runs.at(i).first > last)
+        return false;
+
+    if (_runs.at(i).first < first && _runs.at(i).last > last) {
+        // удаление из середины интервала
+        Run tail {last + 1, _runs.at(i).last};
+        _runs[i].last = first - 1;
+        _runs.insert(i + 1, tail);
+        return true;
+    }
+
+    if (_runs.at(i).first < first) {
+        _runs[i].last = first - 1;
+        i++;
+    }
+
+    int j = i;
+    while (j < _runs.count() && _runs.at(j).last <= last) {
+        j++;
+    }
+    _runs.remove(i, j - i);
+
+    if (i < _runs.count() && _runs.at(i).first <= last)
+        _runs[i].first = last + 1;
+
+    return true;
+}
+
+int RowCheckSet::lowerRun(int row) const
+{
+    auto it = std::lower_bound(_runs.constBegin(), _runs.constEnd(), row, [](const Run& run, int r) { return run.last < r; });
+    return static_cast<int>(it - _runs.constBegin());
+}
+
+} // namespace zf
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QSet>
+#include <QVector>
+
+namespace zf
+{
+/*! Множество выделенных строк в виде упорядоченного списка непересекающихся интервалов. Может хранить как выделенные
+ * строки, так и исключения из режима "выделено все". Поиск строки - двоичный поиск по интервалам. Вставка, удаление и
+ * перемещение строк сдвигают только интервалы, а не отдельные строки */
+class RowCheckSet
+{
+public:
+    RowCheckSet();
+
+    //! Очистить. Если all_checked, то выделены все строки
+    void clear(bool all_checked);
+
+    //! Выделена ли строка
+    bool contains(int row) const;
+    //! Выделены ли все строки (режим "выделено все" без исключений)
+    bool isAllChecked() const;
+    //! Есть ли выделенные строки
+    bool hasChecked() const;
+    //! Режим "выделено все": хранятся исключения
+    bool isInverted() const;
+
+    //! Задать выделение диапазона строк. Возвращает истину, если что-то изменилось
+    bool setChecked(int first, int last, bool checked);
+
+    //! Вставлены строки. Новые строки выделены только в режиме "выделено все"
+    void insertRows(int first, int count);
+    //! Удалены строки
+    void removeRows(int first, int count);
+    //! Перемещены строки start-end перед строкой destination (номер до перемещения)
+    void moveRows(int start, int end, int destination);
+
+    /*! Если в режиме "выделено все" исключения покрывают все строки [0, row_count), то перейти в обычный режим без
+     * выделенных строк. Возвращает истину, если режим изменился */
+    bool normalize(int row_count);
+
+    //! Выделенные строки. Только вне режима "выделено все"
+    QSet<int> toSet() const;
+
+private:
+    //! Интервал строк
+    struct Run
+    {
+        int first;
+        int last;
+    };
+
+    //! Добавить диапазон в список интервалов
+    void addRange(int first, int last);
+    //! Удалить диапазон из списка интервалов. Возвращает истину, если что-то изменилось
+    bool removeRange(int first, int last);
+    //! Индекс первого интервала, у которого last >= row
+    int lowerRun(int row) const;
+
+    //! Интервалы, упорядоченные по возрастанию. Соседние интервалы всегда объединены
+    QVector<Run> _runs;
+    //! Режим "выделено все": _runs содержит исключения
+    bool _inverted = false;
+};
+
+} // namespace zf
@@ -0,0 +1,232 @@
+#include "zf_row_metrics_p.h"
+
+#include <QtGlobal>
+#include <algorithm>
+
+namespace zf
+{
+RowMetrics::RowMetrics()
+{
+}
+
+void RowMetrics::reset(int row_count, int column_count)
+{
+    Q_ASSERT(row_count >= 0 && column_count >= 0);
+
+    _rows.clear();
+    _rows.resize(row_count);
+    _column_count = column_count;
+    _skipped_columns = QBitArray(column_count);
+    _dirty_count = row_count;
+    _height_sum = 0;
+    _height_count = 0;
+}
+
+int RowMetrics::rowCount() const
+{
+    return _rows.count();
+}
+
+int RowMetrics::columnCount() const
+{
+    return _column_count;
+}
+
+void RowMetrics::insertRows(int first, int last)
+{
+    Q_ASSERT(first >= 0 && first <= _rows.count() && last >= first);
+
+    _rows.insert(first, last - first + 1, Row());
+    _dirty_count += last - first + 1;
+}
+
+void RowMetrics::removeRows(int first, int last)
+{
+    Q_ASSERT(first >= 0 && last < _rows.count() && last >= first);
+
+    for (int i = first; i <= last; i++) {
+        if (_rows.at(i).dirty)
+            _dirty_count--;
+        setHeight(_rows[i], -1);
+    }
+    _rows.remove(first, last - first + 1);
+}
+
+void RowMetrics::moveRows(int start, int end, int destination)
+{
+    Q_ASSERT(start >= 0 && end >= start && end < _rows.count() && destination >= 0 && destination <= _rows.count());
+
+    // счетчики не меняются, строки переставляются вместе с рассчитанными размерами
+    if (destination > end + 1)
+        std::rotate(_rows.begin() + start, _rows.begin() + end + 1, _rows.begin() + destination);
+    else if (destination < start)
+        std::rotate(_rows.begin() + destination, _rows.begin() + start, _rows.begin() + end + 1);
+}
+
+void RowMetrics::remapRows(const QVector<int>& new_rows, int row_count)
+{
+    Q_ASSERT(row_count >= 0);
+
+    QVector<Row> rows(row_count);
+    for (int i = 0; i < qMin(new_rows.count(), _rows.count()); i++) {
+        int row = new_rows.at(i);
+        if (row >= 0 && row < row_count)
+            rows[row] = std::move(_rows[i]);
+    }
+    _rows = std::move(rows);
+
+    _dirty_count = 0;
+    _height_sum = 0;
+    _height_count = 0;
+    for (const Row& row : qAsConst(_rows)) {
+        if (row.dirty)
+            _dirty_count++;
+        if (row.height >= 0) {
+            _height_sum += row.height;
+            _height_count++;
+        }
+    }
+}
+
+void RowMetrics::invalidateCells(int first_row, int last_row, int first_column, int last_column)
+{
+    first_row = qMax(0, first_row);
+    last_row = qMin(_rows.count() - 1, last_row);
+    first_column = qMax(0, first_column);
+    last_column = qMin(_column_count - 1, last_column);
+
+    for (int i = first_row; i <= last_row; i++) {
+        Row& row = _rows[i];
+        setDirty(row);
+
+        if (row.cells.isEmpty())
+            continue;
+        for (int col = first_column; col <= last_column; col++) {
+            row.cells[col] = -1;
+        }
+    }
+}
+
+void RowMetrics::invalidateColumn(int column)
+{
+    if (column < 0 || column >= _column_count)
+        return;
+
+    for (Row& row : _rows) {
+        setDirty(row);
+        if (!row.cells.isEmpty())
+            row.cells[column] = -1;
+    }
+}
+
+void RowMetrics::invalidateRows()
+{
+    for (Row& row : _rows) {
+        setDirty(row);
+    }
+}
+
+void RowMetrics::invalidateAll()
+{
+    for (Row& row : _rows) {
+        setDirty(row);
+        row.cells.clear();
+    }
+}
+
+bool RowMetrics::isColumnSkipped(int column) const
+{
+    return column >= 0 && column < _skipped_columns.size() && _skipped_columns.testBit(column);
+}
+
+void RowMetrics::setColumnSkipped(int column, bool skipped)
+{
+    if (column >= 0 && column < _skipped_columns.size())
+        _skipped_columns.setBit(column, skipped);
+}
+
+bool RowMetrics::hasDirtyRows() const
+{
+    return _dirty_count > 0;
+}
+
+bool RowMetrics::isRowDirty(int row) const
+{
+    return _rows.at(row).dirty;
+}
+
+int RowMetrics::cellHeight(int row, int column) const
+{
+    const Row& r = _rows.at(row);
+    return r.cells.isEmpty() ? -1 : r.cells.at(column);
+}
+
+void RowMetrics::setCellHeight(int row, int column, int height)
+{
+    Q_ASSERT(column >= 0 && column < _column_count);
+
+    Row& r = _rows[row];
+    if (r.cells.isEmpty())
+        r.cells.fill(-1, _column_count);
+
+    r.cells[column] = static_cast<qint16>(qBound(0, height, 0x7FFF));
+}
+
+int RowMetrics::rowHeight(int row) const
+{
+    return _rows.at(row).height;
+}
+
+void RowMetrics::setRowHeight(int row, int height)
+{
+    Q_ASSERT(height >= 0);
+
+    Row& r = _rows[row];
+    setHeight(r, height);
+    r.estimated = false;
+    if (r.dirty) {
+        r.dirty = false;
+        _dirty_count--;
+    }
+}
+
+int RowMetrics::averageRowHeight() const
+{
+    return _height_count == 0 ? -1 : static_cast<int>(_height_sum / _height_count);
+}
+
+bool RowMetrics::isRowEstimated(int row) const
+{
+    return _rows.at(row).estimated;
+}
+
+void RowMetrics::setRowEstimated(int row)
+{
+    _rows[row].estimated = true;
+}
+
+void RowMetrics::setDirty(Row& row)
+{
+    if (row.dirty)
+        return;
+
+    row.dirty = true;
+    _dirty_count++;
+}
+
+void RowMetrics::setHeight(Row& row, int height)
+{
+    if (row.height >= 0) {
+        _height_sum -= row.height;
+        _height_count--;
+    }
+
+    row.height = height;
+
+    if (row.height >= 0) {
+        _height_sum += row.height;
+        _height_count++;
+    }
+}
+
+} // namespace zf
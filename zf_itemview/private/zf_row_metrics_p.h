@@ -0,0 +1,97 @@
+#pragma once
+
+#include <QBitArray>
+#include <QVector>
+
+namespace zf
+{
+//! Кэш высот строк таблицы для автоподгона высоты строк под содержимое
+class RowMetrics
+{
+public:
+    RowMetrics();
+
+    //! Сбросить кэш. Все строки требуют пересчета
+    void reset(int row_count, int column_count);
+    //! Количество строк
+    int rowCount() const;
+    //! Количество колонок
+    int columnCount() const;
+
+    //! Вставлены строки. Новые строки требуют пересчета
+    void insertRows(int first, int last);
+    //! Удалены строки
+    void removeRows(int first, int last);
+    //! Перемещены строки start-end перед строкой destination (номер до перемещения)
+    void moveRows(int start, int end, int destination);
+    /*! Строки переупорядочены: new_rows[i] - новый номер строки i или -1, если строка удалена. Строки, в которые ничего не
+     * перемещено, требуют пересчета */
+    void remapRows(const QVector<int>& new_rows, int row_count);
+
+    //! Изменилось содержимое ячеек
+    void invalidateCells(int first_row, int last_row, int first_column, int last_column);
+    //! Изменилась ширина колонки. Ячейки колонки требуют пересчета во всех строках
+    void invalidateColumn(int column);
+    //! Все строки требуют пересчета, но рассчитанные размеры ячеек остаются актуальными (например изменилась видимость колонок)
+    void invalidateRows();
+    //! Все ячейки требуют пересчета
+    void invalidateAll();
+
+    //! Есть ли строки, требующие пересчета
+    bool hasDirtyRows() const;
+    //! Требует ли строка пересчета
+    bool isRowDirty(int row) const;
+
+    //! Рассчитанная высота ячейки. -1, если требует пересчета
+    int cellHeight(int row, int column) const;
+    //! Запомнить рассчитанную высоту ячейки
+    void setCellHeight(int row, int column, int height);
+
+    //! Рассчитанная высота строки. -1, если не рассчитана
+    int rowHeight(int row) const;
+    //! Запомнить рассчитанную высоту строки. Снимает признак необходимости пересчета
+    void setRowHeight(int row, int height);
+
+    //! Средняя высота рассчитанных строк. -1, если ни одна строка не рассчитана
+    int averageRowHeight() const;
+    //! Задана ли для строки, высота которой еще не рассчитывалась, оценочная высота
+    bool isRowEstimated(int row) const;
+    //! Отметить, что для строки задана оценочная высота
+    void setRowEstimated(int row);
+
+    //! Есть ли в колонке ячейки, которые не рассчитывались, т.к. колонка была за пределами видимой области
+    bool isColumnSkipped(int column) const;
+    //! Задать признак наличия нерассчитанных ячеек в колонке
+    void setColumnSkipped(int column, bool skipped);
+
+private:
+    struct Row
+    {
+        //! Требует пересчета
+        bool dirty = true;
+        //! Задана оценочная высота
+        bool estimated = false;
+        //! Высота строки
+        int height = -1;
+        //! Высоты ячеек. -1 - требует пересчета. Пусто, если ни одна ячейка не рассчитана
+        QVector<qint16> cells;
+    };
+
+    //! Пометить строку для пересчета
+    void setDirty(Row& row);
+    //! Изменить высоту строки с учетом суммы высот
+    void setHeight(Row& row, int height);
+
+    QVector<Row> _rows;
+    int _column_count = 0;
+    //! Колонки с пропущенными при расчете ячейками
+    QBitArray _skipped_columns;
+    //! Количество строк, требующих пересчета
+    int _dirty_count = 0;
+    //! Сумма высот рассчитанных строк
+    qint64 _height_sum = 0;
+    //! Количество рассчитанных строк
+    int _height_count = 0;
+};
+
+} // namespace zf
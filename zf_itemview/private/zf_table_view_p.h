@@ -2,6 +2,8 @@
 
 #include <QScrollBar>
 
+#include "zf_visible_rows_p.h"
+
 class QAbstractSliderPrivate;
 
 namespace zf
@@ -36,11 +38,16 @@ public:
     //! Ширина панели
     static int width();
 
+    //! Сбросить кэш положения видимых строк
+    void invalidateRows();
+
 private:
     //! Смещение по вертикали
     int offset() const;
-    //! Положения чекбоксов. Первый rect - размер ячейки, второй - чекбокса
-    QList<QPair<QRect, QRect>> checkboxRects() const;
+    //! Видимые строки. Кэш перестраивается при необходимости
+    const VisibleRows& visibleRows() const;
+    //! Положение чекбокса для ячейки строки
+    QRect checkboxRect(const QRect& cell_rect) const;
     //! Положение чекбокса в заголовке. Первый rect - размер ячейки, второй - чекбокса
     QPair<QRect, QRect> headerCheckboxRect() const;
     //! Размер одного чекбокса
@@ -51,5 +58,7 @@ private:
     TableView* _view;
     bool _ignore_group_check = false;
     bool _is_group_checked = false;
+    //! Кэш положения видимых строк
+    mutable VisibleRows _visible_rows;
 };
 } // namespace zf
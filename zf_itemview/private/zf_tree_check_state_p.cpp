@@ -0,0 +1,336 @@
+#include "zf_tree_check_state_p.h"
+
+#include <QAbstractItemModel>
+#include <algorithm>
+
+namespace zf
+{
+TreeCheckState::TreeCheckState()
+{
+}
+
+void TreeCheckState::clear(bool all_checked)
+{
+    _decisions.clear();
+    _below.clear();
+    _unchecked_children.clear();
+    _checked_count = 0;
+    _root = all_checked;
+}
+
+bool TreeCheckState::isChecked(const QModelIndex& index) const
+{
+    auto it = _decisions.constFind(index);
+    if (it != _decisions.constEnd())
+        return it->self;
+
+    return inheritedState(index);
+}
+
+Qt::CheckState TreeCheckState::checkState(const QModelIndex& index) const
+{
+    bool self = isChecked(index);
+
+    if (decisionsBelow(index) > 0)
+        return Qt::PartiallyChecked;
+
+    if (subtreeState(index) != self && index.model()->hasChildren(index))
+        return Qt::PartiallyChecked;
+
+    return self ? Qt::Checked : Qt::Unchecked;
+}
+
+bool TreeCheckState::isAllChecked() const
+{
+    return _root && _decisions.isEmpty();
+}
+
+bool TreeCheckState::hasChecked() const
+{
+    // если бы все узлы верхнего уровня были сняты, то _root был бы сброшен в normalizeChildren
+    return _root || _checked_count > 0;
+}
+
+bool TreeCheckState::setChecked(const QModelIndex& index, bool checked)
+{
+    Q_ASSERT(index.isValid());
+
+    bool inherited = inheritedState(index);
+    auto it = _decisions.constFind(index);
+    Decision decision = it != _decisions.constEnd() ? *it : Decision {inherited, inherited};
+    if (decision.self == checked)
+        return false;
+
+    decision.self = checked;
+    storeDecision(index, decision, inherited);
+    return true;
+}
+
+bool TreeCheckState::setSubtreeChecked(const QModelIndex& index, bool checked)
+{
+    if (!index.isValid()) {
+        if (_root == checked && _decisions.isEmpty())
+            return false;
+
+        clear(checked);
+        return true;
+    }
+
+    bool inherited = inheritedState(index);
+    if (!_decisions.contains(index) && decisionsBelow(index) == 0 && inherited == checked)
+        return false;
+
+    removeDescendantDecisions(index);
+    storeDecision(index, {checked, checked}, inherited);
+    return true;
+}
+
+QSet<QModelIndex> TreeCheckState::checkedIndexes(const QAbstractItemModel* model) const
+{
+    QSet<QModelIndex> res;
+    if (model != nullptr && hasChecked())
+        checkedIndexesHelper(model, QModelIndex(), _root, res);
+
+    return res;
+}
+
+void TreeCheckState::removeRows(const QAbstractItemModel* model, const QModelIndex& parent, int first, int last)
+{
+    if (model == nullptr || _decisions.isEmpty())
+        return;
+    // в поддереве узла нет решений
+    if (parent.isValid() && decisionsBelow(parent) == 0)
+        return;
+
+    // решения удаляемых строк и их потомков собираются за один проход
+    QList<QPersistentModelIndex> removed;
+    for (auto it = _decisions.constBegin(); it != _decisions.constEnd(); ++it) {
+        for (QModelIndex index = it.key(); index.isValid(); index = index.parent()) {
+            if (index.parent() != parent)
+                continue;
+
+            if (index.row() >= first && index.row() <= last)
+                removed << it.key();
+            break;
+        }
+    }
+
+    for (auto& index : qAsConst(removed)) {
+        removeDecision(index);
+    }
+
+    // оставшиеся дочерние узлы могли оказаться снятыми
+    normalizeChildren(model, parent, model->rowCount(parent) - (last - first + 1));
+}
+
+void TreeCheckState::rebuild()
+{
+    // решения обрабатываются от корня, чтобы унаследованное состояние было уже известно
+    QList<QPersistentModelIndex> indexes;
+    for (auto it = _decisions.constBegin(); it != _decisions.constEnd(); ++it) {
+        if (it.key().isValid())
+            indexes << it.key();
+    }
+    std::sort(indexes.begin(), indexes.end(), [](const QPersistentModelIndex& i1, const QPersistentModelIndex& i2) {
+        return depth(i1) < depth(i2);
+    });
+
+    auto decisions = _decisions;
+    _decisions.clear();
+    _below.clear();
+    _unchecked_children.clear();
+    _checked_count = 0;
+
+    for (auto& index : qAsConst(indexes)) {
+        storeDecision(index, decisions.value(index), inheritedState(index));
+    }
+}
+
+bool TreeCheckState::inheritedState(const QModelIndex& index) const
+{
+    for (QModelIndex parent = index.parent(); parent.isValid(); parent = parent.parent()) {
+        auto it = _decisions.constFind(parent);
+        if (it != _decisions.constEnd())
+            return it->subtree;
+    }
+
+    return _root;
+}
+
+bool TreeCheckState::subtreeState(const QModelIndex& index) const
+{
+    auto it = _decisions.constFind(index);
+    if (it != _decisions.constEnd())
+        return it->subtree;
+
+    return inheritedState(index);
+}
+
+int TreeCheckState::decisionsBelow(const QModelIndex& index) const
+{
+    if (_below.isEmpty())
+        return 0;
+
+    return _below.value(index);
+}
+
+void TreeCheckState::storeDecision(const QModelIndex& index, Decision decision, bool inherited)
+{
+    // у листа нет потомков, поэтому их состояние совпадает с состоянием узла
+    if (!index.model()->hasChildren(index))
+        decision.subtree = decision.self;
+
+    if (decision.self == inherited && decision.subtree == inherited) {
+        removeDecision(index);
+        return;
+    }
+
+    auto it = _decisions.find(index);
+    if (it != _decisions.end()) {
+        countDecision(index, *it, -1);
+        *it = decision;
+
+    } else {
+        _decisions.insert(index, decision);
+        updateAncestorCounters(index, 1);
+    }
+    countDecision(index, decision, 1);
+
+    if (!decision.self && !decision.subtree)
+        normalizeChildren(index.model(), index.parent(), index.model()->rowCount(index.parent()));
+}
+
+void TreeCheckState::removeDecision(const QModelIndex& index)
+{
+    auto it = _decisions.find(index);
+    if (it == _decisions.end())
+        return;
+
+    countDecision(index, *it, -1);
+    _decisions.erase(it);
+    updateAncestorCounters(index, -1);
+}
+
+void TreeCheckState::removeDescendantDecisions(const QModelIndex& index)
+{
+    if (decisionsBelow(index) == 0)
+        return;
+
+    QList<QPersistentModelIndex> descendants;
+    for (auto it = _decisions.constBegin(); it != _decisions.constEnd(); ++it) {
+        if (isAncestor(index, it.key()))
+            descendants << it.key();
+    }
+
+    for (auto& i : qAsConst(descendants)) {
+        removeDecision(i);
+    }
+    Q_ASSERT(decisionsBelow(index) == 0);
+}
+
+void TreeCheckState::updateAncestorCounters(const QModelIndex& index, int delta)
+{
+    for (QModelIndex parent = index.parent(); parent.isValid(); parent = parent.parent()) {
+        auto it = _below.find(parent);
+        if (it == _below.end()) {
+            Q_ASSERT(delta > 0);
+            _below.insert(parent, delta);
+
+        } else {
+            *it += delta;
+            Q_ASSERT(*it >= 0);
+            if (*it == 0)
+                _below.erase(it);
+        }
+    }
+}
+
+void TreeCheckState::countDecision(const QModelIndex& index, const Decision& decision, int delta)
+{
+    if (decision.self || decision.subtree) {
+        _checked_count += delta;
+        Q_ASSERT(_checked_count >= 0);
+        return;
+    }
+
+    auto it = _unchecked_children.find(index.parent());
+    if (it == _unchecked_children.end()) {
+        Q_ASSERT(delta > 0);
+        _unchecked_children.insert(index.parent(), delta);
+
+    } else {
+        *it += delta;
+        Q_ASSERT(*it >= 0);
+        if (*it == 0)
+            _unchecked_children.erase(it);
+    }
+}
+
+void TreeCheckState::normalizeChildren(const QAbstractItemModel* model, const QModelIndex& parent, int row_count)
+{
+    if (row_count <= 0 || _unchecked_children.value(parent) < row_count || !subtreeState(parent))
+        return;
+
+    // решения дочерних узлов совпадут с унаследованным состоянием. Решения их потомков не меняются, т.к. потомки
+    // наследуют то же самое снятое состояние
+    for (int row = 0; row < model->rowCount(parent); row++) {
+        QModelIndex index = model->index(row, 0, parent);
+        auto it = _decisions.constFind(index);
+        if (it != _decisions.constEnd() && !it->self && !it->subtree)
+            removeDecision(index);
+    }
+
+    if (!parent.isValid()) {
+        _root = false;
+        return;
+    }
+
+    bool inherited = inheritedState(parent);
+    auto it = _decisions.constFind(parent);
+    Decision decision = it != _decisions.constEnd() ? *it : Decision {inherited, inherited};
+    decision.subtree = false;
+    storeDecision(parent, decision, inherited);
+}
+
+void TreeCheckState::checkedIndexesHelper(const QAbstractItemModel* model, const QModelIndex& parent, bool parent_subtree, QSet<QModelIndex>& res) const
+{
+    int row_count = model->rowCount(parent);
+    for (int row = 0; row < row_count; row++) {
+        QModelIndex index = model->index(row, 0, parent);
+
+        bool self = parent_subtree;
+        bool subtree = parent_subtree;
+        auto it = _decisions.constFind(index);
+        if (it != _decisions.constEnd()) {
+            self = it->self;
+            subtree = it->subtree;
+        }
+
+        if (self)
+            res << index;
+
+        // поддерево без решений и с невыделенным состоянием не обходим
+        if (subtree || decisionsBelow(index) > 0)
+            checkedIndexesHelper(model, index, subtree, res);
+    }
+}
+
+int TreeCheckState::depth(const QModelIndex& index)
+{
+    int res = 0;
+    for (QModelIndex parent = index.parent(); parent.isValid(); parent = parent.parent()) {
+        res++;
+    }
+    return res;
+}
+
+bool TreeCheckState::isAncestor(const QModelIndex& parent, const QModelIndex& index)
+{
+    for (QModelIndex p = index.parent(); p.isValid(); p = p.parent()) {
+        if (p == parent)
+            return true;
+    }
+    return false;
+}
+
+} // namespace zf
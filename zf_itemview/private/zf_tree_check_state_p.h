@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QHash>
+#include <QPersistentModelIndex>
+#include <QSet>
+
+namespace zf
+{
+/*! Выделение строк дерева чекбоксами. Хранятся только явные решения для узлов, состояние остальных узлов наследуется от
+ * ближайшего предка с решением. Для каждого узла ведется количество решений в его поддереве, что позволяет определять
+ * частичное выделение. Проверка и изменение состояния узла выполняются за время, пропорциональное глубине узла.
+ * Если все дочерние узлы явно сняты вместе с потомками, то снимается состояние потомков самого родителя, поэтому
+ * наличие выделенных узлов определяется по счетчику решений */
+class TreeCheckState
+{
+public:
+    TreeCheckState();
+
+    //! Очистить. Если all_checked, то выделены все узлы
+    void clear(bool all_checked);
+
+    //! Выделен ли узел
+    bool isChecked(const QModelIndex& index) const;
+    //! Состояние узла с учетом потомков: Qt::PartiallyChecked, если состояние потомков отличается от состояния узла
+    Qt::CheckState checkState(const QModelIndex& index) const;
+    //! Выделены ли все узлы
+    bool isAllChecked() const;
+    //! Есть ли выделенные узлы
+    bool hasChecked() const;
+
+    //! Задать выделение узла без изменения потомков. Возвращает истину, если что-то изменилось
+    bool setChecked(const QModelIndex& index, bool checked);
+    //! Задать выделение узла и всех его потомков. Возвращает истину, если что-то изменилось
+    bool setSubtreeChecked(const QModelIndex& index, bool checked);
+
+    //! Выделенные узлы. Обходятся только поддеревья, в которых есть выделенные узлы
+    QSet<QModelIndex> checkedIndexes(const QAbstractItemModel* model) const;
+
+    //! Перед удалением строк first-last узла parent: удаляются решения для этих строк и их потомков. Счетчики
+    //! меняются только у предков удаляемых решений
+    void removeRows(const QAbstractItemModel* model, const QModelIndex& parent, int first, int last);
+    //! Привести в соответствие после перемещения узлов: удаляются решения для несуществующих узлов,
+    //! решения, совпадающие с унаследованным состоянием, и пересчитываются счетчики
+    void rebuild();
+
+private:
+    //! Явное решение для узла
+    struct Decision
+    {
+        //! Состояние самого узла
+        bool self;
+        //! Состояние потомков, для которых нет своего решения
+        bool subtree;
+    };
+
+    //! Состояние, унаследованное узлом от предков
+    bool inheritedState(const QModelIndex& index) const;
+    //! Состояние потомков узла без своего решения
+    bool subtreeState(const QModelIndex& index) const;
+    //! Количество решений в поддереве узла (без самого узла)
+    int decisionsBelow(const QModelIndex& index) const;
+
+    //! Записать решение. Если оно совпадает с унаследованным состоянием, то решение удаляется
+    void storeDecision(const QModelIndex& index, Decision decision, bool inherited);
+    //! Удалить решение
+    void removeDecision(const QModelIndex& index);
+    //! Удалить решения всех потомков узла
+    void removeDescendantDecisions(const QModelIndex& index);
+    //! Изменить счетчики решений у всех предков узла
+    void updateAncestorCounters(const QModelIndex& index, int delta);
+    //! Учесть решение в счетчиках выделенных решений и снятых дочерних узлов
+    void countDecision(const QModelIndex& index, const Decision& decision, int delta);
+    /*! Если все row_count дочерних узлов parent явно сняты вместе с потомками, то снять состояние потомков parent и
+     * удалить ставшие лишними решения дочерних узлов */
+    void normalizeChildren(const QAbstractItemModel* model, const QModelIndex& parent, int row_count);
+
+    void checkedIndexesHelper(const QAbstractItemModel* model, const QModelIndex& parent, bool parent_subtree, QSet<QModelIndex>& res) const;
+
+    //! Глубина узла
+    static int depth(const QModelIndex& index);
+    //! Является ли parent предком index
+    static bool isAncestor(const QModelIndex& parent, const QModelIndex& index);
+
+    //! Явные решения
+    QHash<QPersistentModelIndex, Decision> _decisions;
+    //! Количество решений в поддереве узла
+    QHash<QPersistentModelIndex, int> _below;
+    //! Количество решений, в которых выделен узел или его потомки
+    int _checked_count = 0;
+    //! Количество дочерних узлов с решением "снято вместе с потомками". Ключ - родитель
+    QHash<QPersistentModelIndex, int> _unchecked_children;
+    //! Состояние узлов, для которых нет решений у них самих и их предков
+    bool _root = false;
+};
+
+} // namespace zf
@@ -27,23 +27,18 @@ void TreeCheckBoxPanel::paintEvent(QPaintEvent* e)
     painter.setClipRect(0, 0, _view->width(), _view->height() - 1);
 
     QStyleOptionButton check_option;
-    auto rects = checkboxRects();
+    const auto& rows = visibleRows().rows();
 
     QStyleOptionViewItem grid_option;
     grid_option.initFrom(_view);
 
-    for (auto& rect : qAsConst(rects)) {
-        if (rect.first.isNull())
-            continue;
-
-        QModelIndex row_index = _view->indexAt({0, rect.first.center().y() - offset()});
-        Q_ASSERT(row_index.isValid());
-        row_index = Utils::getTopSourceIndex(row_index);
+    for (auto& visible_row : rows) {
+        QModelIndex row_index = Utils::getTopSourceIndex(visible_row.index);
 
         // чекбокс
         bool checked = _view->isRowChecked(row_index);
         painter.save();
-        check_option.rect = rect.second;
+        check_option.rect = checkboxRect(visible_row.rect);
         check_option.state = QStyle::State_Enabled;
         check_option.state |= checked ? QStyle::State_On : QStyle::State_Off;
 
@@ -56,7 +51,7 @@ void TreeCheckBoxPanel::paintEvent(QPaintEvent* e)
         // линии
         painter.save();
         painter.setPen(Utils::pen(Utils::uiLineColor(true)));
-        painter.drawLine(width() - 1, rect.first.top() - 1, width() - 1, rect.first.bottom());
+        painter.drawLine(width() - 1, visible_row.rect.top() - 1, width() - 1, visible_row.rect.bottom());
         painter.restore();
     }
 
@@ -149,12 +144,20 @@ int TreeCheckBoxPanel::offset() const
     return _view->viewport()->geometry().top() + 1;
 }
 
-QList<QPair<QRect, QRect>> TreeCheckBoxPanel::checkboxRects() const
+void TreeCheckBoxPanel::invalidateRows()
 {
+    _visible_rows.invalidate();
+    update();
+}
+
+const VisibleRows& TreeCheckBoxPanel::visibleRows() const
+{
+    if (_visible_rows.isValid() || _view->model() == nullptr)
+        return _visible_rows;
+
     int first_col = _view->horizontalHeader()->logicalIndexAt(0);
     int offset = this->offset();
-    QSize check_size = checkboxSize();
-    QList<QPair<QRect, QRect>> res;
+    QVector<VisibleRows::Row> rows;
 
     QModelIndex first_visual_index = _view->indexAt({first_col, 0});
     bool found = false;
@@ -166,26 +169,15 @@ QList<QPair<QRect, QRect>> TreeCheckBoxPanel::checkboxRects() const
             if (cell_rect.isNull())
                 break;
 
-            QPair<QRect, QRect> rects;
-
             cell_rect.adjust(0, offset, 0, offset);
-            rects.first = cell_rect;
-
-            cell_rect.setLeft((width() - check_size.width()) / 2);
-            cell_rect.setRight(cell_rect.left() + check_size.width());
 
-            int cell_height = cell_rect.height();
-            cell_rect.setTop(cell_rect.top() + (cell_height - check_size.height()) / 2);
-            cell_rect.setBottom(cell_rect.top() + check_size.height());
-            rects.second = cell_rect;
-
-            if (_view->viewport()->geometry().top() > rects.first.bottom() || _view->viewport()->geometry().bottom() < rects.first.top()) {
-                // возвращаем только видимые части
+            if (_view->viewport()->geometry().top() > cell_rect.bottom() || _view->viewport()->geometry().bottom() < cell_rect.top()) {
+                // запоминаем только видимые части
                 if (found)
                     break;
 
             } else {
-                res << rects;
+                rows << VisibleRows::Row {cell_rect, visual_index};
                 found = true;
             }
         }
@@ -195,7 +187,23 @@ QList<QPair<QRect, QRect>> TreeCheckBoxPanel::checkboxRects() const
             visual_index = visual_index.model()->index(visual_index.row(), first_col, visual_index.parent());
     }
 
-    return res;
+    _visible_rows.setRows(rows);
+    return _visible_rows;
+}
+
+QRect TreeCheckBoxPanel::checkboxRect(const QRect& cell_rect) const
+{
+    QSize check_size = checkboxSize();
+    QRect rect = cell_rect;
+
+    rect.setLeft((width() - check_size.width()) / 2);
+    rect.setRight(rect.left() + check_size.width());
+
+    int cell_height = rect.height();
+    rect.setTop(rect.top() + (cell_height - check_size.height()) / 2);
+    rect.setBottom(rect.top() + check_size.height());
+
+    return rect;
 }
 
 QPair<QRect, QRect> TreeCheckBoxPanel::headerCheckboxRect() const
@@ -235,17 +243,17 @@ QSize TreeCheckBoxPanel::checkboxSize()
 }
 
 QModelIndex TreeCheckBoxPanel::cursorIndex(const QPoint& c) const
-{    
-    auto rects = checkboxRects();
-    int shift = 0;
-    for (auto& rect : qAsConst(rects)) {
-        if (rect.second.contains(c)) {
-            return Utils::getTopSourceIndex(_view->indexAt({0, c.y() - offset()}));
-        }
+{
+    const VisibleRows& visible_rows = visibleRows();
+    int pos = visible_rows.rowAt(c.y());
+    if (pos < 0)
+        return QModelIndex();
 
-        shift++;
-    }
-    return QModelIndex();
+    const VisibleRows::Row& row = visible_rows.rows().at(pos);
+    if (!checkboxRect(row.rect).contains(c))
+        return QModelIndex();
+
+    return Utils::getTopSourceIndex(row.index);
 }
 
 } // namespace zf
@@ -2,6 +2,8 @@
 
 #include <QWidget>
 
+#include "zf_visible_rows_p.h"
+
 namespace zf
 {
 class TreeView;
@@ -22,11 +24,16 @@ public:
     //! Ширина панели
     static int width();
 
+    //! Сбросить кэш положения видимых строк
+    void invalidateRows();
+
 private:
     //! Смещение по вертикали
     int offset() const;
-    //! Положения чекбоксов. Первый rect - размер ячейки, второй - чекбокса
-    QList<QPair<QRect, QRect>> checkboxRects() const;
+    //! Видимые строки. Кэш перестраивается при необходимости
+    const VisibleRows& visibleRows() const;
+    //! Положение чекбокса для ячейки строки
+    QRect checkboxRect(const QRect& cell_rect) const;
     //! Положение чекбокса в заголовке. Первый rect - размер ячейки, второй - чекбокса
     QPair<QRect, QRect> headerCheckboxRect() const;
     //! Размер одного чекбокса
@@ -37,6 +44,8 @@ private:
     TreeView* _view;
     bool _ignore_group_check = false;
     bool _is_group_checked = false;
+    //! Кэш положения видимых строк
+    mutable VisibleRows _visible_rows;
 };
 
 } // namespace zf
@@ -0,0 +1,42 @@
+#include "zf_visible_rows_p.h"
+
+#include <algorithm>
+
+namespace zf
+{
+VisibleRows::VisibleRows()
+{
+}
+
+bool VisibleRows::isValid() const
+{
+    return _valid;
+}
+
+void VisibleRows::invalidate()
+{
+    _valid = false;
+    _rows.clear();
+}
+
+void VisibleRows::setRows(const QVector<Row>& rows)
+{
+    _rows = rows;
+    _valid = true;
+}
+
+const QVector<VisibleRows::Row>& VisibleRows::rows() const
+{
+    return _rows;
+}
+
+int VisibleRows::rowAt(int y) const
+{
+    auto it = std::lower_bound(_rows.constBegin(), _rows.constEnd(), y, [](const Row& row, int y) { return row.rect.bottom() < y; });
+    if (it == _rows.constEnd() || it->rect.top() > y)
+        return -1;
+
+    return static_cast<int>(it - _rows.constBegin());
+}
+
+} // namespace zf
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QModelIndex>
+#include <QRect>
+#include <QVector>
+
+namespace zf
+{
+/*! Кэш положения видимых строк представления для панелей с чекбоксами. Строки упорядочены сверху вниз, поиск строки по
+ * координате - двоичный поиск. Кэш сбрасывается представлением при прокрутке, изменении размеров, высоты строк,
+ * раскрытии/сворачивании узлов и изменении модели */
+class VisibleRows
+{
+public:
+    //! Видимая строка
+    struct Row
+    {
+        //! Положение ячейки строки в координатах панели
+        QRect rect;
+        //! Индекс строки в модели представления
+        QModelIndex index;
+    };
+
+    VisibleRows();
+
+    //! Актуален ли кэш
+    bool isValid() const;
+    //! Сбросить кэш
+    void invalidate();
+
+    //! Задать строки
+    void setRows(const QVector<Row>& rows);
+    //! Видимые строки
+    const QVector<Row>& rows() const;
+
+    //! Номер строки в rows, которая содержит координату y. Если такой нет, то -1
+    int rowAt(int y) const;
+
+private:
+    QVector<Row> _rows;
+    bool _valid = false;
+};
+
+} // namespace zf
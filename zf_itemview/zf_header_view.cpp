@@ -18,6 +18,8 @@
 #include <QScrollBar>
 #include <QTextDocument>
 
+#include <private/qheaderview_p.h>
+
 #define UPDATE_JOINED_PROPERTIES_EVENT (QEvent::User + 10000)
 
 namespace zf
@@ -121,6 +123,9 @@ void HeaderView::paintEvent(QPaintEvent* e)
     QHeaderView::paintEvent(e);
     _painted_rect.clear();
 
+    if (_pinned_section_count > 0 && offset() != 0)
+        paintPinnedSections();
+
     QStylePainter painter(viewport());
 
     if (orientation() == Qt::Vertical) {
@@ -971,6 +976,162 @@ QMap<int, int> HeaderView::getSectionsSizes(int logicalIndex, int new_size) cons
     return sizes;
 }
 
+void HeaderView::setSectionsSize(int first, const QVector<int>& sizes)
+{
+    Q_ASSERT(first >= 0);
+    if (sizes.isEmpty())
+        return;
+
+    const int last = qMin(first + sizes.count(), count()) - 1;
+
+    if (!isBulkResizeAllowed()) {
+        for (int logical = first; logical <= last; logical++) {
+            if (sizes.at(logical - first) >= 0)
+                resizeSection(logical, sizes.at(logical - first));
+        }
+        emit sg_sectionsResized();
+        return;
+    }
+
+    QHeaderViewPrivate* d = privatePtr();
+    // без перемещенных секций визуальный индекс совпадает с логическим
+    const bool moved = !d->visualIndices.isEmpty();
+    bool changed = false;
+    for (int logical = first; logical <= last; logical++) {
+        const int size = sizes.at(logical - first);
+        // те же ограничения, что и в QHeaderView::resizeSection
+        if (size < 0 || size > maximumSectionSize())
+            continue;
+
+        auto& item = d->sectionItems[moved ? visualIndex(logical) : logical];
+        if (item.isHidden) {
+            d->hiddenSectionSize.insert(logical, size);
+            continue;
+        }
+
+        if (static_cast<int>(item.size) == size)
+            continue;
+
+        d->length += size - static_cast<int>(item.size);
+        item.size = static_cast<uint>(size);
+        changed = true;
+    }
+
+    if (changed)
+        finishSectionsResize();
+}
+
+void HeaderView::resetSectionsSize()
+{
+    if (!isBulkResizeAllowed()) {
+        for (int i = 0; i < count(); i++) {
+            resizeSection(i, defaultSectionSize());
+        }
+        emit sg_sectionsResized();
+        return;
+    }
+
+    QHeaderViewPrivate* d = privatePtr();
+    const int size = defaultSectionSize();
+    bool changed = false;
+    for (int visual = 0; visual < d->sectionItems.count(); visual++) {
+        auto& item = d->sectionItems[visual];
+        if (item.isHidden) {
+            d->hiddenSectionSize.insert(logicalIndex(visual), size);
+            continue;
+        }
+
+        if (static_cast<int>(item.size) == size)
+            continue;
+
+        d->length += size - static_cast<int>(item.size);
+        item.size = static_cast<uint>(size);
+        changed = true;
+    }
+
+    if (changed)
+        finishSectionsResize();
+}
+
+bool HeaderView::isBulkResizeAllowed() const
+{
+    // при растягивании размеры соседних секций зависят друг от друга, поэтому нужен штатный механизм Qt
+    return !stretchLastSection() && stretchSectionCount() == 0;
+}
+
+void HeaderView::finishSectionsResize()
+{
+    QHeaderViewPrivate* d = privatePtr();
+    // позиции секций будут пересчитаны один раз при первом обращении
+    d->sectionStartposRecalc = true;
+    d->invalidateCachedSizeHint();
+
+    if (_block_change_header_items_counter == 0 && _limit == 0) {
+        _block_change_header_items_counter++;
+        rootItem()->setSectionsSizes(getSectionsSizes());
+        _block_change_header_items_counter--;
+    }
+
+    viewport()->update();
+    emit sg_sectionsResized();
+}
+
+QHeaderViewPrivate* HeaderView::privatePtr() const
+{
+    return reinterpret_cast<QHeaderViewPrivate*>(d_ptr.data());
+}
+
+void HeaderView::setPinnedSectionCount(int count)
+{
+    Q_ASSERT(orientation() == Qt::Horizontal);
+    Q_ASSERT(count >= 0);
+
+    if (_pinned_section_count == count)
+        return;
+
+    _pinned_section_count = count;
+    viewport()->update();
+}
+
+int HeaderView::pinnedSectionCount() const
+{
+    return _pinned_section_count;
+}
+
+int HeaderView::pinnedWidth() const
+{
+    int count = qMin(_pinned_section_count, this->count());
+    if (count <= 0)
+        return 0;
+
+    int last = logicalIndex(count - 1);
+    return sectionPosition(last) + sectionSize(last);
+}
+
+void HeaderView::paintPinnedSections()
+{
+    int pinned_width = pinnedWidth();
+    if (pinned_width <= 0)
+        return;
+
+    QPainter painter(viewport());
+    painter.setClipRect(0, 0, pinned_width, viewport()->height());
+    painter.fillRect(0, 0, pinned_width, viewport()->height(), palette().brush(QPalette::Button));
+
+    // положение ячеек рассчитывается с учетом прокрутки, поэтому компенсируем ее
+    painter.translate(offset(), 0);
+
+    _painted_rect.clear();
+    for (int visual = 0; visual < qMin(_pinned_section_count, count()); visual++) {
+        int logical = logicalIndex(visual);
+        if (isSectionHidden(logical))
+            continue;
+
+        paintSection(&painter, QRect(sectionViewportPosition(logical), 0, sectionSize(logical), viewport()->height()), logical);
+    }
+    _painted_rect.clear();
+}
+
 void HeaderView::dragEnterEvent(QDragEnterEvent* event)
 {
     if (event->mimeData()->hasFormat(MimeType)) {
@@ -1099,6 +1260,29 @@ bool HeaderView::event(QEvent* event)
     return res;
 }
 
+bool HeaderView::viewportEvent(QEvent* event)
+{
+    if (_pinned_section_count > 0 && offset() != 0
+        && (event->type() == QEvent::MouseButtonPress || event->type() == QEvent::MouseButtonRelease
+            || event->type() == QEvent::MouseButtonDblClick || event->type() == QEvent::MouseMove)) {
+        auto e = static_cast<QMouseEvent*>(event);
+        if (e->pos().x() < pinnedWidth()) {
+            // закрепленные секции отображаются без смещения, а обработка мыши в QHeaderView учитывает прокрутку
+            QPointF pos(e->pos().x() - offset(), e->pos().y());
+#if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
+            QMouseEvent pinned_event(e->type(), pos, e->windowPos(), e->screenPos(), e->button(), e->buttons(), e->modifiers());
+#else
+            QMouseEvent pinned_event(e->type(), pos, e->scenePosition(), e->globalPosition(), e->button(), e->buttons(), e->modifiers());
+#endif
+            bool res = QHeaderView::viewportEvent(&pinned_event);
+            event->setAccepted(pinned_event.isAccepted());
+            return res;
+        }
+    }
+
+    return QHeaderView::viewportEvent(event);
+}
+
 void HeaderView::sl_sectionResized(int logical_index, int old_size, int new_size)
 {
     Q_UNUSED(old_size)
@@ -1245,9 +1429,21 @@ void HeaderView::copyJoinedProperties()
     // установка размера по умолчанию сбрасывает текущие размеры, зачем - загадка
     setDefaultSectionSize(joinedHeader()->defaultSectionSize());
 
+    QVector<int> restore(count(), -1);
     for (int i = 0; i < count(); i++) {
-        if (sectionResizeMode(i) == QHeaderView::ResizeMode::Interactive)
-            resizeSection(i, sizes.at(i));
+        if (sectionResizeMode(i) == QHeaderView::ResizeMode::Interactive && sectionSize(i) != sizes.at(i))
+            restore[i] = sizes.at(i);
+    }
+
+    if (orientation() == Qt::Vertical) {
+        // строк может быть очень много
+        setSectionsSize(0, restore);
+
+    } else {
+        for (int i = 0; i < restore.count(); i++) {
+            if (restore.at(i) >= 0)
+                resizeSection(i, restore.at(i));
+        }
     }
 }
 
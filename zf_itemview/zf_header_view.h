@@ -11,11 +11,15 @@
 Q_DECLARE_OPAQUE_POINTER(zf::HeaderItem*)
 #endif
 
+class QHeaderViewPrivate;
+
 namespace zf
 {
 class HeaderItem;
 
-//! Иерархический заголовок. Не использовать напрямую, только через HeaderItem
+/*! Иерархический заголовок. Не использовать напрямую, только через HeaderItem.
+ * Массовое изменение размера секций (подгон высоты строк таблицы, синхронизация с фиксированной таблицей) выполняется
+ * за один проход: вместо sectionResized для каждой секции генерируется один sg_sectionsResized */
 class ZF_ITEMVIEW_DLL_API HeaderView : public QHeaderView
 {
     Q_OBJECT
@@ -102,6 +106,9 @@ signals:
     void sg_beforeLoadDataFromRootHeader();
     //! Вызывается после окончания перезагрузки данных из rootItem
     void sg_afterLoadDataFromRootHeader();
+    //! Изменился размер группы секций через setSectionsSize или resetSectionsSize. sectionResized для каждой секции при
+    //! этом не генерируется
+    void sg_sectionsResized();
 
 protected:
     void mousePressEvent(QMouseEvent* event) override;
@@ -113,6 +120,7 @@ protected:
     void dragLeaveEvent(QDragLeaveEvent* event) override;
     void resizeEvent(QResizeEvent* event) override;
     void paintEvent(QPaintEvent* event) override;    
+    bool viewportEvent(QEvent* event) override;
     void customEvent(QEvent* event) override;
     bool event(QEvent* event) override;
     QModelIndex indexAt(const QPoint& pos) const override;
@@ -203,6 +211,29 @@ private:
         //! Принудительно задать new_size для logicalIndex
         int new_size = -1) const;
 
+    /*! Задать размер секций first, first + 1, ... за один проход. sizes[i] - размер логической секции first + i, -1 -
+     * размер не меняется. В отличие от resizeSection позиции секций пересчитываются один раз, а sectionResized для
+     * секций НЕ генерируется: вместо него генерируется один sg_sectionsResized */
+    void setSectionsSize(int first, const QVector<int>& sizes);
+    //! Установить всем секциям размер по умолчанию за один проход
+    void resetSectionsSize();
+    //! Можно ли менять размер секций напрямую, минуя resizeSection
+    bool isBulkResizeAllowed() const;
+    //! Завершение изменения размера группы секций
+    void finishSectionsResize();
+
+    //! Доступ к QHeaderViewPrivate
+    QHeaderViewPrivate* privatePtr() const;
+
+    //! Закрепить первые count визуальных секций (с учетом скрытых). При горизонтальной прокрутке они отображаются без
+    //! смещения поверх остальных секций
+    void setPinnedSectionCount(int count);
+    int pinnedSectionCount() const;
+    //! Ширина закрепленной области
+    int pinnedWidth() const;
+    //! Отрисовка закрепленных секций
+    void paintPinnedSections();
+
     QMimeData* encodeMimeData(const QPoint& pos, const QModelIndex& index) const;
     void decodeMimeData(
         const QMimeData* data, const QObject* source_object, QPoint& source_pos, QModelIndex& source_index) const;
@@ -314,6 +345,8 @@ private:
     ItemViewHeaderModel* _model = nullptr;
     HeaderView* _joined_header = nullptr;
     int _limit = 0;
+    //! Количество закрепленных секций
+    int _pinned_section_count = 0;
     bool _allow_sorting = false;
     bool _allow_config = true;
 
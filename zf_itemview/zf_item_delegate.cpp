@@ -87,6 +87,7 @@ ItemDelegate::ItemDelegate(QAbstractItemView* item_view, QAbstractItemView* main
     , _view_mode(false)
 {
     Q_ASSERT(_item_view != nullptr);
+    _static_text_cache.setMaxCost(5000);
 }
 
 void ItemDelegate::setUseHtml(bool b)
@@ -101,6 +102,21 @@ bool ItemDelegate::isUseHtml() const
     return _use_html;
 }
 
+void ItemDelegate::setUseTextCache(bool b)
+{
+    if (b == _use_text_cache)
+        return;
+    _use_text_cache = b;
+
+    if (!_use_text_cache)
+        _static_text_cache.clear();
+}
+
+bool ItemDelegate::isUseTextCache() const
+{
+    return _use_text_cache;
+}
+
 QAbstractItemView* ItemDelegate::itemView() const
 {
     lazyInit();
@@ -500,7 +516,8 @@ void ItemDelegate::paintCellContent(QStyle* style, QPainter* p, const QStyleOpti
 {
     Q_UNUSED(index)
 
-    if (_use_html && HtmlTools::isHtml(opt->text)) {
+    bool is_html = _use_html && HtmlTools::isHtml(opt->text);
+    if (is_html || _use_text_cache) {
         // код выдран из QCommonStyle::drawControl
 
         p->setClipRect(opt->rect);
@@ -557,7 +574,10 @@ void ItemDelegate::paintCellContent(QStyle* style, QPainter* p, const QStyleOpti
                 p->drawRect(textRect.adjusted(0, 0, -1, -1));
             }
 
-            viewItemDrawText(style, p, opt, textRect);
+            if (is_html)
+                viewItemDrawText(style, p, opt, textRect);
+            else
+                viewItemDrawCachedText(style, p, opt, textRect);
         }
 
         // draw the focus rect
@@ -626,6 +646,109 @@ void ItemDelegate::viewItemDrawText(QStyle* style, QPainter* p, const QStyleOpti
     }
 }
 
+void ItemDelegate::viewItemDrawCachedText(QStyle* style, QPainter* p, const QStyleOptionViewItem* option, const QRect& rect) const
+{
+    const QWidget* widget = option->widget;
+    const int textMargin = style->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, widget) + 1;
+
+    QRect textRect = rect.adjusted(textMargin, 0, -textMargin, 0); // remove width padding
+    if (textRect.width() <= 0 || textRect.height() <= 0)
+        return;
+
+    const bool wrap_text = option->features & QStyleOptionViewItem::WrapText;
+    const Qt::Alignment alignment = QStyle::visualAlignment(option->direction, option->displayAlignment);
+
+    const QChar separator = QLatin1Char('|');
+    const QString key = option->font.key() + separator + QString::number(textRect.width()) + separator + QString::number(textRect.height())
+                        + separator + QString::number(static_cast<int>(alignment)) + separator + QString::number(static_cast<int>(option->direction))
+                        + separator + QString::number(static_cast<int>(option->textElideMode)) + separator + (wrap_text ? QLatin1Char('1') : QLatin1Char('0'))
+                        + separator + option->text;
+
+    StaticTextRun* run = _static_text_cache.object(key);
+    if (run == nullptr) {
+        // раскладка текста по аналогии с QCommonStylePrivate::viewItemDrawText
+        QString text = option->text;
+        text.replace(QLatin1Char('\n'), QChar::LineSeparator);
+
+        QTextOption text_option;
+        text_option.setWrapMode(wrap_text ? QTextOption::WordWrap : QTextOption::ManualWrap);
+        text_option.setTextDirection(option->direction);
+        text_option.setAlignment(alignment);
+
+        QTextLayout text_layout(text, option->font);
+        text_layout.setTextOption(text_option);
+        int last_visible_line = -1;
+        viewItemTextLayout(text_layout, textRect.width(), textRect.height(), &last_visible_line);
+
+        const QFontMetrics fm(option->font);
+        const int line_count = last_visible_line >= 0 ? last_visible_line + 1 : text_layout.lineCount();
+
+        qreal height = 0;
+        if (line_count > 0) {
+            QTextLine last_line = text_layout.lineAt(line_count - 1);
+            height = last_line.y() + last_line.height();
+        }
+
+        qreal top = 0;
+        if (alignment & Qt::AlignBottom)
+            top = textRect.height() - height;
+        else if (alignment & Qt::AlignVCenter)
+            top = (textRect.height() - height) / 2;
+
+        run = new StaticTextRun;
+        for (int i = 0; i < line_count; i++) {
+            QTextLine line = text_layout.lineAt(i);
+
+            QString line_text;
+            if (i == last_visible_line)
+                // не поместившийся остаток текста сокращаем в последней видимой строке
+                line_text = text.mid(line.textStart());
+            else
+                line_text = text.mid(line.textStart(), line.textLength());
+
+            while (!line_text.isEmpty() && line_text.at(line_text.length() - 1).isSpace())
+                line_text.chop(1);
+            if (i == last_visible_line)
+                line_text.replace(QChar::LineSeparator, QLatin1Char(' '));
+
+            if (i == last_visible_line || !wrap_text)
+                line_text = fm.elidedText(line_text, option->textElideMode, textRect.width());
+
+            if (line_text.isEmpty())
+                continue;
+
+            const int line_width = fm.
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+                                   horizontalAdvance
+#else
+                                   width
+#endif
+                                   (line_text);
+            qreal left = 0;
+            if (alignment & Qt::AlignRight)
+                left = textRect.width() - line_width;
+            else if (alignment & Qt::AlignHCenter)
+                left = (textRect.width() - line_width) / 2.0;
+
+            StaticTextLine static_line;
+            static_line.pos = QPointF(left, top + line.y());
+            static_line.text.setText(line_text);
+            static_line.text.setTextFormat(Qt::PlainText);
+            static_line.text.setPerformanceHint(QStaticText::AggressiveCaching);
+            static_line.text.prepare(QTransform(), option->font);
+            run->lines << static_line;
+        }
+
+        _static_text_cache.insert(key, run, qMax(1, run->lines.count()));
+    }
+
+    p->setFont(option->font);
+    const QPointF origin = textRect.topLeft();
+    for (auto& line : qAsConst(run->lines)) {
+        p->drawStaticText(origin + line.pos, line.text);
+    }
+}
+
 void ItemDelegate::initTextDocument(const QStyleOptionViewItem* option, const QModelIndex& index, QTextDocument& doc) const
 {
     QStyleOptionViewItem optionV4 = *option;
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "zf_itemview.h"
+#include <QCache>
 #include <QPointer>
+#include <QStaticText>
 #include <QStyledItemDelegate>
 
 class QTextOption;
@@ -50,6 +52,10 @@ public:
     void setUseHtml(bool b);
     bool isUseHtml() const;
 
+    //! Кэшировать результат раскладки простого (не html) текста ячеек. Ускоряет перерисовку при прокрутке
+    void setUseTextCache(bool b);
+    bool isUseTextCache() const;
+
     //! QAbstractItemView, который обслуживает делегат
     QAbstractItemView* itemView() const;
     //! QAbstractItemView от которого наследуется состояние фокуса и т.п.
@@ -109,6 +115,9 @@ private:
     //! Отрисовка текста ячейки (частично выдрано из QCommonStyle)
     void viewItemDrawText(QStyle* style, QPainter* p, const QStyleOptionViewItem* option, const QRect& rect) const;
 
+    //! Отрисовка простого текста ячейки через кэш QStaticText
+    void viewItemDrawCachedText(QStyle* style, QPainter* p, const QStyleOptionViewItem* option, const QRect& rect) const;
+
     //! Инициализация rich text
     void initTextDocument(const QStyleOptionViewItem* option, const QModelIndex& index, QTextDocument& doc) const;
 
@@ -133,6 +142,23 @@ private:
 
     //! Использовать html форматирование
     bool _use_html = true;
+
+    //! Строка простого текста, подготовленная для отрисовки
+    struct StaticTextLine
+    {
+        QPointF pos;
+        QStaticText text;
+    };
+    //! Результат раскладки простого текста ячейки
+    struct StaticTextRun
+    {
+        QVector<StaticTextLine> lines;
+    };
+
+    //! Кэшировать результат раскладки простого текста
+    bool _use_text_cache = false;
+    //! Кэш раскладки простого текста. Ключ: текст, шрифт, размер области, перенос, выравнивание и режим сокращения
+    mutable QCache<QString, StaticTextRun> _static_text_cache;
 };
 
 } // namespace zf
@@ -8,8 +8,11 @@
 
 #include <private/qtableview_p.h>
 #include <private/qabstractslider_p.h>
+#include <private/qheaderview_p.h>
 
+#include "private/zf_cell_check_store_p.h"
 #include "private/zf_item_view_p.h"
+#include "private/zf_row_check_set_p.h"
 #include "private/zf_table_view_p.h"
 
 #include <QApplication>
@@ -60,20 +63,15 @@ void CheckBoxPanel::paintEvent(QPaintEvent* e)
     painter.setClipRect(0, 0, _view->width(), _view->height() - 1);
 
     QStyleOptionButton check_option;
-    auto rects = checkboxRects();
+    const auto& rows = visibleRows().rows();
 
-    for (auto& rect : qAsConst(rects)) {
-        if (rect.first.isNull())
-            continue;
-
-        int row = _view->rowAt(rect.first.center().y() - offset());
-        Q_ASSERT(row >= 0);
-        row = Utils::getTopSourceIndex(_view->model()->index(row, 0)).row();
+    for (auto& visible_row : rows) {
+        int row = Utils::getTopSourceIndex(visible_row.index).row();
 
         // чекбокс
         bool checked = _view->isRowChecked(row);
         painter.save();
-        check_option.rect = rect.second;
+        check_option.rect = checkboxRect(visible_row.rect);
         check_option.state = QStyle::State_Enabled;
         check_option.state |= checked ? QStyle::State_On : QStyle::State_Off;
 
@@ -95,10 +93,10 @@ void CheckBoxPanel::paintEvent(QPaintEvent* e)
         painter.setPen(gridPen);
 
         if (_view->showGrid())
-            painter.drawLine(1, rect.first.bottom(), width() - 1, rect.first.bottom());
+            painter.drawLine(1, visible_row.rect.bottom(), width() - 1, visible_row.rect.bottom());
 
         painter.setPen(Utils::pen(Utils::uiLineColor(true)));
-        painter.drawLine(width() - 1, rect.first.top() - 1, width() - 1, rect.first.bottom());
+        painter.drawLine(width() - 1, visible_row.rect.top() - 1, width() - 1, visible_row.rect.bottom());
         painter.restore();
     }
 
@@ -184,47 +182,61 @@ int CheckBoxPanel::offset() const
     return _view->viewport()->geometry().top() + 1;
 }
 
-QList<QPair<QRect, QRect>> CheckBoxPanel::checkboxRects() const
+void CheckBoxPanel::invalidateRows()
+{
+    _visible_rows.invalidate();
+    update();
+}
+
+const VisibleRows& CheckBoxPanel::visibleRows() const
 {
+    if (_visible_rows.isValid() || _view->model() == nullptr)
+        return _visible_rows;
+
     int first_col = _view->horizontalHeader()->logicalIndexAt(0);
     int offset = this->offset();
-    QSize check_size = checkboxSize();
-    QList<QPair<QRect, QRect>> res;
+    QVector<VisibleRows::Row> rows;
 
     int first_visual_row = _view->rowAt(0);
     bool found = false;
 
     for (int visual_row = first_visual_row; true; visual_row++) {
-        QRect cell_rect = _view->visualRect(_view->model()->index(visual_row, first_col));
+        QModelIndex index = _view->model()->index(visual_row, first_col);
+        QRect cell_rect = _view->visualRect(index);
 
         if (cell_rect.isNull())
             break;
 
-        QPair<QRect, QRect> rects;
-
         cell_rect.adjust(0, offset, 0, offset);
-        rects.first = cell_rect;
-
-        cell_rect.setLeft((width() - check_size.width()) / 2);
-        cell_rect.setRight(cell_rect.left() + check_size.width());
 
-        int cell_height = cell_rect.height();
-        cell_rect.setTop(cell_rect.top() + (cell_height - check_size.height()) / 2);
-        cell_rect.setBottom(cell_rect.top() + check_size.height());
-        rects.second = cell_rect;
-
-        if (_view->viewport()->geometry().top() > rects.first.bottom() || _view->viewport()->geometry().bottom() < rects.first.top()) {
-            // возвращаем только видимые части
+        if (_view->viewport()->geometry().top() > cell_rect.bottom() || _view->viewport()->geometry().bottom() < cell_rect.top()) {
+            // запоминаем только видимые части
             if (found)
                 break;
             continue;
         }
 
-        res << rects;
+        rows << VisibleRows::Row {cell_rect, index};
         found = true;
     }
 
-    return res;
+    _visible_rows.setRows(rows);
+    return _visible_rows;
+}
+
+QRect CheckBoxPanel::checkboxRect(const QRect& cell_rect) const
+{
+    QSize check_size = checkboxSize();
+    QRect rect = cell_rect;
+
+    rect.setLeft((width() - check_size.width()) / 2);
+    rect.setRight(rect.left() + check_size.width());
+
+    int cell_height = rect.height();
+    rect.setTop(rect.top() + (cell_height - check_size.height()) / 2);
+    rect.setBottom(rect.top() + check_size.height());
+
+    return rect;
 }
 
 QPair<QRect, QRect> CheckBoxPanel::headerCheckboxRect() const
@@ -265,16 +277,16 @@ QSize CheckBoxPanel::checkboxSize()
 
 int CheckBoxPanel::cursorRow(const QPoint& c) const
 {
-    auto rects = checkboxRects();
-    int shift = 0;
-    for (auto& rect : qAsConst(rects)) {
-        if (rect.second.contains(c)) {
-            return Utils::getTopSourceIndex(_view->indexAt({0, c.y() - offset()})).row();
-        }
+    const VisibleRows& visible_rows = visibleRows();
+    int pos = visible_rows.rowAt(c.y());
+    if (pos < 0)
+        return -1;
 
-        shift++;
-    }
-    return -1;
+    const VisibleRows::Row& row = visible_rows.rows().at(pos);
+    if (!checkboxRect(row.rect).contains(c))
+        return -1;
+
+    return Utils::getTopSourceIndex(row.index).row();
 }
 
 QWidget* TableView::cornerWidget() const
@@ -336,6 +348,37 @@ void TableView::setFrozenGroupCount(int count)
     updateFrozenCount();
 }
 
+bool TableView::isFrozenPinned() const
+{
+    return _frozen_pinned;
+}
+
+void TableView::setFrozenPinned(bool b)
+{
+    if (_frozen_pinned == b)
+        return;
+
+    _frozen_pinned = b;
+
+    if (b) {
+        if (_frozen_table_view != nullptr) {
+            horizontalHeader()->setJoinedHeader(nullptr);
+            verticalHeader()->setJoinedHeader(nullptr);
+
+            delete _frozen_table_view;
+            _frozen_table_view = nullptr;
+            delete _frozen_table_line;
+            _frozen_table_line = nullptr;
+        }
+
+    } else {
+        horizontalHeader()->setPinnedSectionCount(0);
+    }
+
+    updateFrozenCount();
+    viewport()->update();
+}
+
 void TableView::setUseHtml(bool b)
 {
     TableViewBase::setUseHtml(b);
@@ -344,12 +387,20 @@ void TableView::setUseHtml(bool b)
         _frozen_table_view->setUseHtml(b);
 }
 
-void TableView::requestResizeRowsToContents()
+void TableView::setUseTextCache(bool b)
 {
-    TableViewBase::requestResizeRowsToContents();
+    TableViewBase::setUseTextCache(b);
 
     if (_frozen_table_view != nullptr)
-        _frozen_table_view->requestResizeRowsToContents();
+        _frozen_table_view->setUseTextCache(b);
+}
+
+void TableView::setHoverTracking(bool b)
+{
+    TableViewBase::setHoverTracking(b);
+
+    if (_frozen_table_view != nullptr)
+        _frozen_table_view->setHoverTracking(b);
 }
 
 Error TableView::serialize(QIODevice* device) const
@@ -448,6 +499,25 @@ QModelIndex TableView::moveCursor(QAbstractItemView::CursorAction cursorAction,
 
 void TableView::scrollTo(const QModelIndex& index, QAbstractItemView::ScrollHint hint)
 {
+    if (_frozen_pinned && index.isValid() && frozenGroupCount() > 0) {
+        if (isPinnedColumn(index.column())) {
+            // закрепленная колонка видна всегда, прокручиваем только по вертикали
+            int h_value = horizontalScrollBar()->value();
+            TableViewBase::scrollTo(index, hint);
+            horizontalScrollBar()->setValue(h_value);
+
+        } else {
+            TableViewBase::scrollTo(index, hint);
+
+            // колонка не должна оставаться под закрепленной областью
+            int pos = pinnedWidth();
+            int left = columnViewportPosition(index.column());
+            if (left < pos)
+                horizontalScrollBar()->setValue(horizontalScrollBar()->value() + left - pos);
+        }
+        return;
+    }
+
     if (!index.isValid() || horizontalHeader()->visualIndex(index.column()) > frozenSectionCount(false) - 1) {
         TableViewBase::scrollTo(index, hint);
     } else {
@@ -459,12 +529,29 @@ void TableView::scrollTo(const QModelIndex& index, QAbstractItemView::ScrollHint
     }
 }
 
+QModelIndex TableView::indexAt(const QPoint& pos) const
+{
+    if (isPinnedShifted() && pos.x() < pinnedWidth())
+        return TableViewBase::indexAt({pos.x() - horizontalHeader()->offset(), pos.y()});
+
+    return TableViewBase::indexAt(pos);
+}
+
+QRect TableView::visualRect(const QModelIndex& index) const
+{
+    QRect rect = TableViewBase::visualRect(index);
+    if (index.isValid() && isPinnedShifted() && isPinnedColumn(index.column()))
+        rect.translate(horizontalHeader()->offset(), 0);
+
+    return rect;
+}
+
 void TableView::updateGeometries()
 {
     TableViewBase::updateGeometries();
 
     _check_panel->setGeometry(0, 0, leftPanelWidth(), geometry().height());
-    _check_panel->update();
+    _check_panel->invalidateRows();
 }
 
 void TableView::setModel(QAbstractItemModel* model)
@@ -488,8 +575,8 @@ void TableView::setModel(QAbstractItemModel* model)
         connect(model, &QAbstractItemModel::modelReset, this, &TableView::sl_modelReset);
     }
 
-    _checked.clear();
-    _all_checked = false;
+    _checked->clear(false);
+    _check_panel->invalidateRows();
 
     TableViewBase::setModel(model);
 }
@@ -512,41 +599,27 @@ bool TableView::isShowCheckRowPanel() const
 
 bool TableView::hasCheckedRows() const
 {
-    return isAllRowsChecked() || !_checked.isEmpty();
+    return _checked->hasChecked();
 }
 
 bool TableView::isRowChecked(int row) const
 {
-    if (_all_checked)
-        return true;
-
-    return _checked.contains(row);
+    return _checked->contains(row);
 }
 
 void TableView::checkRow(int row, bool checked)
 {
-    if (isRowChecked(row) == checked)
-        return;
-
-    if (checked) {
-        if (_all_checked)
-            return;
+    checkRows(row, row, checked);
+}
 
-        _checked << row;
-    } else {
-        if (_all_checked) {
-            Q_ASSERT(_checked.isEmpty());
-            for (int i = 0; i < model()->rowCount(); i++) {
-                if (row == i)
-                    continue;
-                _checked << i;
-            }
-            _all_checked = false;
+void TableView::checkRows(int first_row, int last_row, bool checked)
+{
+    Q_ASSERT(first_row >= 0 && first_row <= last_row);
 
-        } else {
-            _checked.remove(row);
-        }
-    }
+    // при снятии выделения в режиме "выделено все" строка попадает в исключения
+    if (!_checked->setChecked(first_row, last_row, checked))
+        return;
+    _checked->normalize(model() == nullptr ? 0 : model()->rowCount());
 
     _check_panel->update();
     emit sg_checkedRowsChanged();
@@ -554,33 +627,34 @@ void TableView::checkRow(int row, bool checked)
 
 QSet<int> TableView::checkedRows() const
 {
-    if (isAllRowsChecked() && _checked.isEmpty()) {
+    if (_checked->isInverted()) {
         QSet<int> res;
         QModelIndexList all_indexes;
         Utils::getAllIndexes(model(), all_indexes);
 
         for (auto& i : qAsConst(all_indexes)) {
-            res << Utils::getTopSourceIndex(i).row();
+            int row = Utils::getTopSourceIndex(i).row();
+            if (_checked->contains(row))
+                res << row;
         }
 
         return res;
     }
 
-    return _checked;
+    return _checked->toSet();
 }
 
 bool TableView::isAllRowsChecked() const
 {
-    return _all_checked;
+    return _checked->isAllChecked();
 }
 
 void TableView::checkAllRows(bool checked)
 {
-    if (_all_checked && checked)
+    if (checked && _checked->isAllChecked())
         return;
 
-    _checked.clear();
-    _all_checked = checked;
+    _checked->clear(checked);
 
     _check_panel->update();
     emit sg_checkedRowsChanged();
@@ -614,74 +688,85 @@ void TableView::setCellCheckColumn(int logical_index, bool visible, bool enabled
 bool TableView::isCellChecked(const QModelIndex& index) const
 {
     Q_ASSERT(index.isValid());
-    QModelIndex source_index = sourceIndex(index);
-
-    for (int i = _cell_checked.count() - 1; i >= 0; i--) {
-        if (!_cell_checked.at(i).isValid()) {
-            _cell_checked.removeAt(i);
-            continue;
-        }
-
-        if (_cell_checked.at(i) == source_index)
-            return true;
-    }
-
-    return false;
+    return _cell_checked->isChecked(sourceIndex(index));
 }
 
 void TableView::setCellChecked(const QModelIndex& index, bool checked)
 {
     Q_ASSERT(index.isValid());
     QModelIndex source_index = sourceIndex(index);
-    QModelIndex view_index = Utils::alignIndexToModel(index, model());
 
-    for (int i = _cell_checked.count() - 1; i >= 0; i--) {
-        if (!_cell_checked.at(i).isValid()) {
-            _cell_checked.removeAt(i);
-            continue;
-        }
+    if (!_cell_checked->setChecked(source_index, checked))
+        return;
 
-        if (_cell_checked.at(i) != source_index)
-            continue;
+    emit sg_checkedCellChanged(source_index, checked);
 
-        if (checked)
-            return;
+    QModelIndex view_index = Utils::alignIndexToModel(index, model());
+    if (view_index.isValid())
+        update(view_index);
+}
 
-        _cell_checked.removeAt(i);
-        emit sg_checkedCellChanged(source_index, false);
-        if (view_index.isValid())
-            update(view_index);
+QModelIndexList TableView::checkedCells() const
+{
+    return _cell_checked->checkedCells();
+}
+
+void TableView::clearCheckedCells()
+{
+    const QModelIndexList cells = _cell_checked->checkedCells();
+    if (cells.isEmpty())
         return;
-    }
 
-    if (checked) {
-        _cell_checked << source_index;
-        emit sg_checkedCellChanged(source_index, true);
-        if (view_index.isValid())
-            update(view_index);
+    _cell_checked->clear();
+    for (auto& c : cells) {
+        emit sg_checkedCellChanged(c, false);
     }
+
+    viewport()->update();
+    if (_frozen_table_view != nullptr)
+        _frozen_table_view->viewport()->update();
 }
 
-QModelIndexList TableView::checkedCells() const
+void TableView::setCellsChecked(const QModelIndex& top_left, const QModelIndex& bottom_right, bool checked)
 {
-    QModelIndexList res;
-    for (int i = _cell_checked.count() - 1; i >= 0; i--) {
-        if (!_cell_checked.at(i).isValid()) {
-            _cell_checked.removeAt(i);
-            continue;
-        }
+    Q_ASSERT(top_left.isValid() && bottom_right.isValid());
+    Q_ASSERT(top_left.model() == model() && bottom_right.model() == model());
+    Q_ASSERT(top_left.parent() == bottom_right.parent());
 
-        res << _cell_checked.at(i);
+    int changed = 0;
+    if (Utils::getTopSourceModel(model()) == model()) {
+        // прокси нет - диапазон совпадает с диапазоном source модели
+        changed = _cell_checked->setChecked(
+            model(), top_left.parent(), top_left.row(), bottom_right.row(), top_left.column(), bottom_right.column(), checked);
+
+    } else {
+        for (int row = top_left.row(); row <= bottom_right.row(); row++) {
+            for (int column = top_left.column(); column <= bottom_right.column(); column++) {
+                if (_cell_checked->setChecked(sourceIndex(model()->index(row, column, top_left.parent())), checked))
+                    changed++;
+            }
+        }
     }
 
-    return res;
+    if (changed == 0)
+        return;
+
+    viewport()->update();
+    if (_frozen_table_view != nullptr)
+        _frozen_table_view->viewport()->update();
+    emit sg_checkedCellsChanged();
 }
 
-void TableView::clearCheckedCells()
+void TableView::setColumnCellsChecked(int logical_index, bool checked)
 {
-    for (auto& c : qAsConst(_cell_checked)) {
-        setCellChecked(c, false);
-    }
+    if (model() == nullptr)
+        return;
+
+    const int row_count = model()->rowCount(rootIndex());
+    if (row_count == 0)
+        return;
+
+    setCellsChecked(model()->index(0, logical_index, rootIndex()), model()->index(row_count - 1, logical_index, rootIndex()), checked);
 }
 
 bool TableView::isAutoShrink() const
@@ -848,8 +933,15 @@ bool TableView::eventFilter(QObject* watched, QEvent* event)
 
 void TableView::scrollContentsBy(int dx, int dy)
 {
-    TableViewBase::scrollContentsBy(dx, dy);
-    _check_panel->update();
+    if (_frozen_pinned && dx != 0 && pinnedWidth() > 0)
+        scrollPinnedContentsBy(dx, dy);
+    else
+        TableViewBase::scrollContentsBy(dx, dy);
+
+    if (dy != 0)
+        _check_panel->invalidateRows();
+    else
+        _check_panel->update();
 }
 
 int TableView::leftPanelWidth() const
@@ -857,9 +949,88 @@ int TableView::leftPanelWidth() const
     return TableViewBase::leftPanelWidth() + (isShowCheckRowPanel() ? CheckBoxPanel::width() : 0);
 }
 
+QRegion TableView::visualRegionForSelection(const QItemSelection& selection) const
+{
+    QRegion region = TableViewBase::visualRegionForSelection(selection);
+    if (!isPinnedShifted())
+        return region;
+
+    // закрепленные ячейки отображаются без горизонтального смещения, поэтому их область берется из visualRect
+    for (auto& range : selection) {
+        if (!range.isValid() || range.parent() != rootIndex())
+            continue;
+
+        for (int column = range.left(); column <= range.right(); column++) {
+            if (!isPinnedColumn(column))
+                continue;
+
+            QRect top = visualRect(model()->index(range.top(), column, rootIndex()));
+            QRect bottom = visualRect(model()->index(range.bottom(), column, rootIndex()));
+            region += top.united(bottom);
+        }
+    }
+
+    return region;
+}
+
+void TableView::setSelection(const QRect& rect, QItemSelectionModel::SelectionFlags command)
+{
+    if (!isPinnedShifted() || selectionModel() == nullptr || model() == nullptr) {
+        TableViewBase::setSelection(rect, command);
+        return;
+    }
+
+    // углы прямоугольника переводятся в ячейки через indexAt, который учитывает закрепленную область
+    QRect r = rect.normalized();
+    QModelIndex top_left = indexAt(isRightToLeft() ? r.topRight() : r.topLeft());
+    QModelIndex bottom_right = indexAt(isRightToLeft() ? r.bottomLeft() : r.bottomRight());
+    if (!top_left.isValid() || !bottom_right.isValid())
+        return;
+
+    int top = qMin(verticalHeader()->visualIndex(top_left.row()), verticalHeader()->visualIndex(bottom_right.row()));
+    int bottom = qMax(verticalHeader()->visualIndex(top_left.row()), verticalHeader()->visualIndex(bottom_right.row()));
+    int left = qMin(horizontalHeader()->visualIndex(top_left.column()), horizontalHeader()->visualIndex(bottom_right.column()));
+    int right = qMax(horizontalHeader()->visualIndex(top_left.column()), horizontalHeader()->visualIndex(bottom_right.column()));
+
+    QItemSelection selection;
+    for (int v = top; v <= bottom; v++) {
+        int row = verticalHeader()->logicalIndex(v);
+        if (verticalHeader()->isSectionHidden(row))
+            continue;
+
+        // подряд идущие логические колонки объединяются в один диапазон
+        int first = -1;
+        int last = -1;
+        for (int h = left; h <= right + 1; h++) {
+            int column = h <= right ? horizontalHeader()->logicalIndex(h) : -1;
+            if (column >= 0 && horizontalHeader()->isSectionHidden(column))
+                continue;
+
+            if (column >= 0 && first >= 0 && column == last + 1) {
+                last = column;
+                continue;
+            }
+
+            if (first >= 0)
+                selection.append(QItemSelectionRange(model()->index(row, first, rootIndex()), model()->index(row, last, rootIndex())));
+
+            first = column;
+            last = column;
+        }
+    }
+
+    if (selectionBehavior() == SelectRows)
+        command |= QItemSelectionModel::Rows;
+    else if (selectionBehavior() == SelectColumns)
+        command |= QItemSelectionModel::Columns;
+
+    selectionModel()->select(selection, command);
+}
+
 void TableView::sl_horizontalGeometriesChanged()
 {
     updateCornerWidget();
+    updatePinnedSections();
     updateFrozenTableGeometry();
     _check_panel->update();
 }
@@ -911,17 +1082,28 @@ void TableView::updateCornerWidget()
 
 void TableView::sl_verticalSectionResized(int logicalIndex, int oldSize, int newSize)
 {
-    Q_UNUSED(logicalIndex)
     Q_UNUSED(oldSize)
-    Q_UNUSED(newSize)
+
+    // фиксированная таблица высоту строк не рассчитывает и берет ее из основной
+    if (_frozen_table_view != nullptr && _frozen_table_view->verticalHeader()->sectionSize(logicalIndex) != newSize)
+        _frozen_table_view->verticalHeader()->resizeSection(logicalIndex, newSize);
 
     updateFrozenTableGeometry();
+    _check_panel->invalidateRows();
+}
+
+void TableView::sl_verticalSectionsResized()
+{
+    syncFrozenRowHeights();
+    updateFrozenTableGeometry();
+    _check_panel->invalidateRows();
 }
 
 void TableView::sl_verticalGeometriesChanged()
 {
     updateCornerWidget();
     updateFrozenTableGeometry();
+    _check_panel->invalidateRows();
 }
 
 void TableView::sl_rootItemHiddenChanged(const QList<HeaderItem*>& bottom_items, bool is_hide)
@@ -956,8 +1138,6 @@ void TableView::sl_frozen_horizontalSectionResized(int logicalIndex, int oldSize
     Q_UNUSED(newSize)
 
     updateFrozenTableGeometry();
-    if (_frozen_table_view != nullptr)
-        _frozen_table_view->requestResizeRowsToContents();
 }
 
 void TableView::sl_frozenClicked(const QModelIndex& index)
@@ -981,74 +1161,48 @@ void TableView::sl_frozenCloseEditor(QWidget* w)
 
 void TableView::sl_layoutChanged()
 {
-    _check_panel->update();
+    _check_panel->invalidateRows();
 }
 
 void TableView::sl_rowsRemoved(const QModelIndex& parent, int first, int last)
 {
     Q_UNUSED(parent)
 
-    if (!_checked.isEmpty()) {
-        for (int row = first; row <= last; row++) {
-            _checked.remove(row);
-        }
-
-        // коррекция
-        QSet<int> update_checked;
-        for (auto row : qAsConst(_checked)) {
-            if (row > last) {
-                update_checked << row - 1 - (last - first);
-            } else {
-                update_checked << row;
-            }
-        }
-        _checked = update_checked;
-    }
-
-    _check_panel->update();
+    _checked->removeRows(first, last - first + 1);
+    _checked->normalize(model()->rowCount());
+    _check_panel->invalidateRows();
 }
 
 void TableView::sl_rowsInserted(const QModelIndex& parent, int first, int last)
 {
     Q_UNUSED(parent)
 
-    if (!_checked.isEmpty()) {
-        // коррекция
-        QSet<int> update_checked;
-        for (auto row : qAsConst(_checked)) {
-            if (row > last) {
-                update_checked << row + 1 + (last - first);
-            } else {
-                update_checked << row;
-            }
-        }
-        _checked = update_checked;
-    }
-
-    _check_panel->update();
+    _checked->insertRows(first, last - first + 1);
+    _check_panel->invalidateRows();
 }
 
 void TableView::sl_rowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row)
 {
-    Q_UNUSED(parent);
-    Q_UNUSED(start);
-    Q_UNUSED(end);
-    Q_UNUSED(destination);
-    Q_UNUSED(row);
+    if (parent == destination)
+        _checked->moveRows(start, end, row);
+    else
+        _checked->clear(false);
 
-    _checked.clear();
-    _check_panel->update();
+    _check_panel->invalidateRows();
 }
 
 void TableView::sl_modelReset()
 {
-    _check_panel->update();
+    _check_panel->invalidateRows();
 }
 
 void TableView::init()
 {
     _auto_resize_rows = true;
 
+    _cell_checked = new CellCheckStore(this);
+    _checked = std::make_shared<RowCheckSet>();
+
     _check_panel = new CheckBoxPanel(this);
     _check_panel->setHidden(true);
 
@@ -1058,6 +1212,7 @@ void TableView::init()
 
     connect(verticalHeader(), &HeaderView::geometriesChanged, this, &TableView::sl_verticalGeometriesChanged);
     connect(verticalHeader(), &HeaderView::sectionResized, this, &TableView::sl_verticalSectionResized);
+    connect(verticalHeader(), &HeaderView::sg_sectionsResized, this, &TableView::sl_verticalSectionsResized);
 
     // иначе не будет обновляться отрисовка фильтра и т.п. глюки
     connect(horizontalScrollBar(), &QScrollBar::valueChanged, this, [&]() { horizontalHeader()->viewport()->update(); });
@@ -1120,6 +1275,9 @@ void TableView::updateFrozenTableGeometry()
 
 int TableView::frozenRightPos() const
 {
+    if (_frozen_pinned)
+        return pinnedWidth();
+
     if (_frozen_table_view == nullptr || _frozen_table_view->horizontalHeader()->count() == _frozen_table_view->horizontalHeader()->hiddenSectionCount())
         return 0;
 
@@ -1138,7 +1296,8 @@ int TableView::frozenRightPos() const
 
 void TableView::updateFrozenCurrentCellPosition()
 {
-    if (_frozen_table_view == nullptr)
+    // в режиме закрепленной области текущая ячейка выводится из-под нее в scrollTo
+    if (_frozen_table_view == nullptr || _frozen_pinned)
         return;
 
     QModelIndex current = currentIndex();
@@ -1171,9 +1330,16 @@ void TableView::updateFrozenCurrentCellPosition()
 
 void TableView::updateFrozenCount()
 {
+    if (_frozen_pinned) {
+        updatePinnedSections();
+        return;
+    }
+
     if (_frozen_group_count == 0) {
-        _frozen_table_view->hide();
-        _frozen_table_line->hide();
+        if (_frozen_table_view != nullptr) {
+            _frozen_table_view->hide();
+            _frozen_table_line->hide();
+        }
 
     } else {
         if (_frozen_table_view == nullptr) {
@@ -1187,8 +1353,11 @@ void TableView::updateFrozenCount()
 
             _frozen_table_view = new FrozenTableView(this);
 
-            if (qobject_cast<ItemDelegate*>(itemDelegate()) != nullptr)
+            if (qobject_cast<ItemDelegate*>(itemDelegate()) != nullptr) {
                 _frozen_table_view->setUseHtml(isUseHtml());
+                _frozen_table_view->setUseTextCache(isUseTextCache());
+            }
+            _frozen_table_view->setHoverTracking(isHoverTracking());
 
             _frozen_table_view->setObjectName("frozen_table_view");
             _frozen_table_view->setModel(model());
@@ -1230,7 +1399,7 @@ void TableView::updateFrozenCount()
             _frozen_table_view->show();
             _frozen_table_line->show();
 
-            _frozen_table_view->requestResizeRowsToContents();
+            syncFrozenRowHeights();
         }
 
         if (_frozen_table_view->isHidden()) {
@@ -1239,10 +1408,31 @@ void TableView::updateFrozenCount()
         }
     }
 
+    if (_frozen_table_view == nullptr)
+        return;
+
     _frozen_table_view->horizontalHeader()->setLimit(_frozen_group_count);
     updateFrozenTableGeometry();
 }
 
+void TableView::syncFrozenRowHeights()
+{
+    if (_frozen_table_view == nullptr)
+        return;
+
+    HeaderView* header = _frozen_table_view->verticalHeader();
+    QVector<int> sizes(qMin(header->count(), verticalHeader()->count()), -1);
+    bool changed = false;
+    for (int i = 0; i < sizes.count(); i++) {
+        if (header->sectionSize(i) != verticalHeader()->sectionSize(i)) {
+            sizes[i] = verticalHeader()->sectionSize(i);
+            changed = true;
+        }
+    }
+    if (changed)
+        header->setSectionsSize(0, sizes);
+}
+
 void TableView::blockUpdateFrozenGeometry()
 {
     _block_update_geometry_count++;
@@ -1257,6 +1447,127 @@ void TableView::unblockUpdateFrozenGeometry()
         updateFrozenTableGeometry();
 }
 
+int TableView::pinnedWidth() const
+{
+    if (!_frozen_pinned)
+        return 0;
+
+    return horizontalHeader()->pinnedWidth();
+}
+
+bool TableView::isPinnedColumn(int logical_index) const
+{
+    if (!_frozen_pinned)
+        return false;
+
+    int visual = horizontalHeader()->visualIndex(logical_index);
+    return visual >= 0 && visual < horizontalHeader()->pinnedSectionCount();
+}
+
+bool TableView::isPinnedShifted() const
+{
+    return _frozen_pinned && horizontalHeader()->pinnedSectionCount() > 0 && horizontalHeader()->offset() != 0;
+}
+
+void TableView::updatePinnedSections()
+{
+    if (!_frozen_pinned)
+        return;
+
+    int count = frozenSectionCount(false);
+    if (horizontalHeader()->pinnedSectionCount() == count)
+        return;
+
+    horizontalHeader()->setPinnedSectionCount(count);
+    viewport()->update();
+}
+
+void TableView::paintPinned(QPaintEvent* event)
+{
+    int pinned_width = pinnedWidth();
+    QRect rect = event->rect() & QRect(0, 0, pinned_width, viewport()->height());
+    if (rect.isEmpty())
+        return;
+
+    if (isPinnedShifted()) {
+        {
+            QPainter painter(viewport());
+            painter.fillRect(rect, viewport()->palette().brush(viewport()->backgroundRole()));
+        }
+
+        /* Закрепленные колонки рисуются штатной отрисовкой таблицы при нулевом смещении заголовка. Смещение меняется
+         * напрямую в QHeaderViewPrivate, т.к. QHeaderView::setOffset прокручивает заголовок */
+        QHeaderViewPrivate* header_private = horizontalHeader()->privatePtr();
+        int offset = header_private->offset;
+        header_private->offset = 0;
+        QPaintEvent pinned_event(rect);
+        TableViewBase::paintEvent(&pinned_event);
+        header_private->offset = offset;
+    }
+
+    // граница закрепленной области
+    QPainter painter(viewport());
+    painter.setPen(Utils::pen(Utils::uiLineColor(true)));
+    painter.drawLine(pinned_width - 1, rect.top(), pinned_width - 1, rect.bottom());
+}
+
+void TableView::scrollPinnedContentsBy(int dx, int dy)
+{
+    QTableViewPrivate* d = reinterpret_cast<QTableViewPrivate*>(d_ptr.data());
+    d->delayedAutoScroll.stop();
+
+    dx = isRightToLeft() ? -dx : dx;
+    if (dx != 0) {
+        int old_offset = horizontalHeader()->offset();
+        if (horizontalScrollMode() == ScrollPerItem) {
+            if (horizontalScrollBar()->maximum() > 0 && horizontalScrollBar()->value() == horizontalScrollBar()->maximum())
+                horizontalHeader()->setOffsetToLastSection();
+            else
+                horizontalHeader()->setOffsetToSectionPosition(horizontalScrollBar()->value());
+
+            int new_offset = horizontalHeader()->offset();
+            dx = isRightToLeft() ? new_offset - old_offset : old_offset - new_offset;
+
+        } else {
+            horizontalHeader()->setOffset(horizontalScrollBar()->value());
+        }
+    }
+
+    if (dy != 0) {
+        int old_offset = verticalHeader()->offset();
+        if (verticalScrollMode() == ScrollPerItem) {
+            if (verticalScrollBar()->maximum() > 0 && verticalScrollBar()->value() == verticalScrollBar()->maximum())
+                verticalHeader()->setOffsetToLastSection();
+            else
+                verticalHeader()->setOffsetToSectionPosition(verticalScrollBar()->value());
+
+            dy = old_offset - verticalHeader()->offset();
+
+        } else {
+            verticalHeader()->setOffset(verticalScrollBar()->value());
+        }
+    }
+
+    d->scrollDirtyRegion(dx, dy);
+
+    // закрепленная область по горизонтали не переносится
+    int pinned_width = pinnedWidth();
+    viewport()->scroll(dx, dy, QRect(pinned_width, 0, viewport()->width() - pinned_width, viewport()->height()));
+    if (dy != 0)
+        viewport()->scroll(0, dy, QRect(0, 0, pinned_width, viewport()->height()));
+
+    if (showGrid()) {
+        // аналогично QTableView::scrollContentsBy
+        if (dy > 0 && horizontalHeader()->isHidden())
+            viewport()->update(0, dy, viewport()->width(), dy);
+        if (dx > 0 && verticalHeader()->isHidden())
+            viewport()->update(dx, 0, dx, viewport()->height());
+    }
+
+    // при переносе части области редакторы не перемещаются вместе с ней
+    updateEditorGeometries();
+}
+
 QModelIndex TableView::sourceIndex(const QModelIndex& index) const
 {
     Q_ASSERT(index.isValid());
@@ -1283,7 +1594,20 @@ HeaderItem* TableView::rootHeaderItem(Qt::Orientation orientation) const
 
 void TableView::paintEvent(QPaintEvent* event)
 {
-    TableViewBase::paintEvent(event);
+    if (isPinnedShifted()) {
+        // закрепленная область рисуется отдельно в paintPinned, поэтому исключаем ее из основной отрисовки
+        QRegion region = event->region() - QRect(0, 0, pinnedWidth(), viewport()->height());
+        if (!region.isEmpty()) {
+            QPaintEvent unpinned_event(region);
+            TableViewBase::paintEvent(&unpinned_event);
+        }
+
+    } else {
+        TableViewBase::paintEvent(event);
+    }
+
+    if (_frozen_pinned && horizontalHeader()->pinnedSectionCount() > 0)
+        paintPinned(event);
 
     if (_frozen_table_view) {
         /* Синхронизация свойств таблицы с таблицей фиксированных колонок. Т.к. методы установки большинства свойств
@@ -12,6 +12,8 @@ namespace zf
 class HeaderView;
 class FrozenTableView;
 class CheckBoxPanel;
+class CellCheckStore;
+class RowCheckSet;
 
 //! Таблица с иерархическим заголовком
 class ZF_ITEMVIEW_DLL_API TableView : public TableViewBase
@@ -46,12 +48,18 @@ public:
     int frozenGroupCount() const override;
     //! Установить количество зафиксированных групп (узлов верхнего уровня)
     void setFrozenGroupCount(int count) override;
+    //! Отображать зафиксированные колонки как закрепленную область основной таблицы, а не встроенной таблицей
+    //! FrozenTableView. Данные и сигналы модели обрабатываются одним представлением, при горизонтальной прокрутке
+    //! переносится только незакрепленная часть
+    bool isFrozenPinned() const;
+    void setFrozenPinned(bool b);
 
     //! Использовать html форматирование
     void setUseHtml(bool b) override;
-
-    //! Запросить подгонку строк по высоте
-    void requestResizeRowsToContents() override;
+    //! Кэшировать раскладку простого текста ячеек
+    void setUseTextCache(bool b) override;
+    //! Отслеживать наведение мыши на ячейки
+    void setHoverTracking(bool b) override;
 
     //! Сохранить состояние заголовков
     Error serialize(QIODevice* device) const;
@@ -75,6 +83,10 @@ public: // выделение строк (панель слева от табл
     void checkRow(
         //! Если TableView подключена к наследнику QAbstractProxyModel, то это номер строки source
         int row, bool checked);
+    //! Задать выделение диапазона строк чекбоксами
+    void checkRows(
+        //! Если TableView подключена к наследнику QAbstractProxyModel, то это номера строк source
+        int first_row, int last_row, bool checked);
     //! Выделенные строки
     QSet<int> checkedRows() const;
     //! Все строки выделены чекбоксами
@@ -104,6 +116,10 @@ public: // выделение ячеек (чекбоксы внутри ячее
     QModelIndexList checkedCells() const override;
     //! Очистить все выделение чекбоксами
     void clearCheckedCells() override;
+    //! Задать состояние чекбоксов диапазона ячеек. Генерирует sg_checkedCellsChanged
+    void setCellsChecked(const QModelIndex& top_left, const QModelIndex& bottom_right, bool checked);
+    //! Задать состояние чекбоксов всех ячеек колонки. Генерирует sg_checkedCellsChanged
+    void setColumnCellsChecked(int logical_index, bool checked);
 
 public:
     //! Автоматически растягивать высоту под количество строк
@@ -121,13 +137,15 @@ public:
 
 public:
     void scrollTo(const QModelIndex& index, ScrollHint hint = EnsureVisible) override;
+    QModelIndex indexAt(const QPoint& pos) const override;
+    QRect visualRect(const QModelIndex& index) const override;
     void updateGeometries() override;
     void setModel(QAbstractItemModel* model) override;
 
     //! Выводим в паблик
     using TableViewBase::viewOptions;
 
-    //! Встроенная таблица с фиксированными колонками
+    //! Встроенная таблица с фиксированными колонками. В режиме isFrozenPinned не создается
     TableViewBase* frozenTableView() const;
 
 protected:
@@ -144,6 +162,8 @@ protected:
     void customEvent(QEvent* event) override;
     bool eventFilter(QObject* watched, QEvent* event) override;
     void scrollContentsBy(int dx, int dy) override;
+    QRegion visualRegionForSelection(const QItemSelection& selection) const override;
+    void setSelection(const QRect& rect, QItemSelectionModel::SelectionFlags command) override;
 
     //! Ширина бокового сдвига
     int leftPanelWidth() const override;
@@ -157,10 +177,15 @@ signals:
     void sg_checkedCellChanged(
         //! Если TableView подключена к наследнику QAbstractProxyModel, то это индекс source
         const QModelIndex& index, bool checked) override;
+    //! Изменилось выделение группы ячеек чекбоксами (setCellsChecked, setColumnCellsChecked). sg_checkedCellChanged для
+    //! каждой ячейки при этом не генерируется
+    void sg_checkedCellsChanged();
 
 private slots:
     void sl_horizontalGeometriesChanged();    
     void sl_verticalSectionResized(int logicalIndex, int oldSize, int newSize);
+    //! Изменился размер группы строк
+    void sl_verticalSectionsResized();
     void sl_verticalGeometriesChanged();
 
     //! Изменилась видимость
@@ -209,10 +234,25 @@ private:
 
     //! Обновить количество фиксированных колонок
     void updateFrozenCount();
+    //! Скопировать высоту строк в фиксированную таблицу
+    void syncFrozenRowHeights();
 
     void blockUpdateFrozenGeometry();
     void unblockUpdateFrozenGeometry();
 
+    //! Ширина закрепленной области (режим isFrozenPinned)
+    int pinnedWidth() const;
+    //! Находится ли колонка в закрепленной области
+    bool isPinnedColumn(int logical_index) const;
+    //! Есть ли закрепленная область, смещенная относительно прокрученных колонок
+    bool isPinnedShifted() const;
+    //! Обновить количество закрепленных секций заголовка
+    void updatePinnedSections();
+    //! Отрисовать закрепленную область поверх прокрученных колонок
+    void paintPinned(QPaintEvent* event);
+    //! Прокрутка, при которой по горизонтали переносится только незакрепленная часть (аналог QTableView::scrollContentsBy)
+    void scrollPinnedContentsBy(int dx, int dy);
+
     QModelIndex sourceIndex(const QModelIndex& index) const;
 
     //! Виджет в левом верхнем углу
@@ -232,6 +272,8 @@ private:
     FrozenTableView* _frozen_table_view = nullptr;
     QFrame* _frozen_table_line = nullptr;
     int _frozen_group_count = 0;
+    //! Зафиксированные колонки отображаются закрепленной областью основной таблицы
+    bool _frozen_pinned = false;
 
     bool _block_select_current = false;
     //! Флаг обновления свойств фиксированной таблицы
@@ -243,9 +285,7 @@ private:
     //! Панель с чекбоксами
     CheckBoxPanel* _check_panel;
     //! Выделенные строки
-    QSet<int> _checked;
-    //! Все строки выделены
-    int _all_checked = false;
+    std::shared_ptr<RowCheckSet> _checked;
 
     //! Автоподгон высоты виджета
     bool _auto_shrink = false;
@@ -260,8 +300,8 @@ private:
 
     //! Колонки, в ячейках которых, находятся чекбоксы (ключ - логические индексы колонок, значение - можно менять)
     QMap<int, bool> _cell_check_columns;
-    //! Состояние чекбокса ячейки. Если TableView подключена к наследнику QAbstractProxyModel, то это номер индекс source
-    mutable QList<QPersistentModelIndex> _cell_checked;
+    //! Состояние чекбокса ячейки. Если TableView подключена к наследнику QAbstractProxyModel, то это индекс source
+    CellCheckStore* _cell_checked = nullptr;
 };
 
 } // namespace zf
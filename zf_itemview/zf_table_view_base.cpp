@@ -5,7 +5,9 @@
 #include "zf_utils.h"
 
 #include <QApplication>
+#include <QBitArray>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QScrollBar>
@@ -14,10 +16,14 @@
 #include <private/qabstractslider_p.h>
 
 #include "private/zf_item_view_p.h"
+#include "private/zf_row_metrics_p.h"
 #include "private/zf_table_view_p.h"
 
 namespace zf
 {
+//! Сколько времени (мс) за один раз тратить на фоновое уточнение высоты строк
+static const int _refine_rows_time_limit = 15;
+
 TableViewBase::TableViewBase(QWidget* parent)
     : QTableView(parent)
 {
@@ -35,6 +41,12 @@ void TableViewBase::setModel(QAbstractItemModel* model)
 
     if (this->model() != nullptr) {
         disconnect(this->model(), &QAbstractItemModel::rowsRemoved, this, &TableViewBase::sl_rowsRemoved);
+        disconnect(this->model(), &QAbstractItemModel::rowsMoved, this, &TableViewBase::sl_rowsMoved);
+        disconnect(this->model(), &QAbstractItemModel::layoutAboutToBeChanged, this, &TableViewBase::sl_layoutAboutToBeChanged);
+        disconnect(this->model(), &QAbstractItemModel::layoutChanged, this, &TableViewBase::sl_layoutChanged);
+        disconnect(this->model(), &QAbstractItemModel::columnsInserted, this, &TableViewBase::sl_columnsChanged);
+        disconnect(this->model(), &QAbstractItemModel::columnsRemoved, this, &TableViewBase::sl_columnsChanged);
+        disconnect(this->model(), &QAbstractItemModel::columnsMoved, this, &TableViewBase::sl_columnsChanged);
         disconnect(this->model(), &QAbstractItemModel::modelReset, this, &TableViewBase::sl_modelReset);
     }
 
@@ -42,9 +54,20 @@ void TableViewBase::setModel(QAbstractItemModel* model)
 
     if (model != nullptr) {        
         connect(model, &QAbstractItemModel::rowsRemoved, this, &TableViewBase::sl_rowsRemoved);
+        connect(model, &QAbstractItemModel::rowsMoved, this, &TableViewBase::sl_rowsMoved);
+        connect(model, &QAbstractItemModel::layoutAboutToBeChanged, this, &TableViewBase::sl_layoutAboutToBeChanged);
+        connect(model, &QAbstractItemModel::layoutChanged, this, &TableViewBase::sl_layoutChanged);
+        connect(model, &QAbstractItemModel::columnsInserted, this, &TableViewBase::sl_columnsChanged);
+        connect(model, &QAbstractItemModel::columnsRemoved, this, &TableViewBase::sl_columnsChanged);
+        connect(model, &QAbstractItemModel::columnsMoved, this, &TableViewBase::sl_columnsChanged);
         connect(model, &QAbstractItemModel::modelReset, this, &TableViewBase::sl_modelReset);
 
+        if (isRowMetricsOwner())
+            _row_metrics->reset(model->rowCount(rootIndex()), model->columnCount(rootIndex()));
         requestResizeRowsToContents();
+
+    } else if (isRowMetricsOwner()) {
+        _row_metrics->reset(0, 0);
     }
 }
 
@@ -118,6 +141,44 @@ bool TableViewBase::isUseHtml() const
     return false;
 }
 
+void TableViewBase::setUseTextCache(bool b)
+{
+    if (auto d = qobject_cast<ItemDelegate*>(itemDelegate())) {
+        d->setUseTextCache(b);
+        update();
+    } else {
+        Q_ASSERT(false);
+    }
+}
+
+bool TableViewBase::isUseTextCache() const
+{
+    if (auto d = qobject_cast<ItemDelegate*>(itemDelegate()))
+        return d->isUseTextCache();
+
+    Q_ASSERT(false);
+    return false;
+}
+
+void TableViewBase::setHoverTracking(bool b)
+{
+    if (_hover_tracking == b)
+        return;
+
+    _hover_tracking = b;
+    viewport()->setAttribute(Qt::WA_Hover, b);
+
+    if (_hover_index.isValid())
+        update(_hover_index);
+    _hover_index = QPersistentModelIndex();
+    _hover_check = false;
+}
+
+bool TableViewBase::isHoverTracking() const
+{
+    return _hover_tracking;
+}
+
 int TableViewBase::horizontalHeaderHeight() const
 {
     int height = qMax(horizontalHeader()->minimumHeight(), horizontalHeader()->sizeHint().height());
@@ -301,6 +362,9 @@ void TableViewBase::updateGeometries()
 
     _geometry_recursion_block = false;
     QAbstractItemView::updateGeometries();
+
+    // при расширении области просмотра в нее могут попасть колонки, ячейки которых не рассчитывались
+    checkSkippedColumns();
 }
 
 bool TableViewBase::isReloading() const
@@ -334,7 +398,11 @@ QSize TableViewBase::sizeHint() const
 
 void TableViewBase::requestResizeRowsToContents()
 {
-    _resize_timer->start();
+    if (!isRowMetricsOwner())
+        return;
+
+    _row_metrics->invalidateAll();
+    startResizeRows();
 }
 
 HeaderView* TableViewBase::horizontalHeader() const
@@ -366,10 +434,15 @@ void TableViewBase::onColumnsDragFinished()
 
 void TableViewBase::onColumnResized(int column, int oldWidth, int newWidth)
 {
-    Q_UNUSED(column)
     Q_UNUSED(oldWidth)
     Q_UNUSED(newWidth)
-    requestResizeRowsToContents();
+
+    if (!isRowMetricsOwner())
+        return;
+
+    // при смене ширины колонки перенос текста меняется только в ее ячейках
+    _row_metrics->invalidateColumn(column);
+    startResizeRows();
 }
 
 void TableViewBase::delegateGetCheckInfo(QAbstractItemView* item_view, const QModelIndex& index, bool& show, bool& checked) const
@@ -399,72 +472,103 @@ void TableViewBase::paintEvent(QPaintEvent* event)
 
         int last_visible_visual = header->visualIndex(header->rootItem()->lastVisibleSection());
 
-        // отрисовка вертикальных линий по всей таблице
+        // отрисовка вертикальных линий только в пределах перерисовываемой области
         painter.save();
 
+        const QRect exposed = event->rect();
+        int first_col = header->visualIndexAt(exposed.left());
+        int last_col = header->visualIndexAt(exposed.right());
+        first_col = first_col < 0 ? first_visible_visual : qMax(first_col, first_visible_visual);
+        last_col = last_col < 0 ? last_visible_visual : qMin(last_col, last_visible_visual);
+
         int row_count = model()->rowCount();
-        int bottom_row = rowAt(height());
-        QPair<int, int> bottom_interval; // интервал между последней видимой строкой и нижней границей виджета
+        int top_row = rowAt(exposed.top());
+        int bottom_row = rowAt(exposed.bottom());
+        int free_top = -1; // начало интервала между последней видимой строкой и нижней границей виджета
         if (bottom_row < 0) {
             // внизу таблицы есть свободное пространство, по которому надо дорисовать вертикальные линии
             if (row_count == 0) {
-                bottom_interval = QPair<int, int>(0, viewport()->rect().bottom());
+                free_top = 0;
 
             } else {
-                int last_item_pos
-                    = visualRect(model()->index(row_count - 1, header->logicalIndex(first_visible_visual))).top();
+                int last_item_pos = rowViewportPosition(row_count - 1);
                 if (last_item_pos >= 0)
-                    bottom_interval = QPair<int, int>(last_item_pos, viewport()->rect().bottom());
+                    free_top = last_item_pos;
 
                 bottom_row = row_count - 1;
             }
         }
+        const int frame_rows = top_row >= 0 ? bottom_row - top_row + 1 : 0;
+        const int frame_cols = last_col - first_col + 1;
+
+        // границы строк кадра
+        QVector<QPair<int, int>> row_bounds(frame_rows);
+        for (int row = top_row; row < top_row + frame_rows; row++) {
+            int top = rowViewportPosition(row);
+            int bottom = top + rowHeight(row);
+            if (row == row_count - 1)
+                bottom--;
+            row_bounds[row - top_row] = QPair<int, int>(top, bottom);
+        }
 
-        for (int vusual_col = first_visible_visual; vusual_col <= last_visible_visual; vusual_col++) {
-            int logical_col = header->logicalIndex(vusual_col);
-
-            if (header->isSectionHidden(logical_col))
-                continue;
-
-            int left = header->sectionViewportPosition(logical_col);
-
-            QList<QPair<int, int>> intervals;
-            if (bottom_interval.first >= 0)
-                intervals << bottom_interval;
+        // ячейки кадра, входящие в объединение колонок. Для них линии не рисуются
+        QBitArray spanned;
+        if (reinterpret_cast<QTableViewPrivate*>(d_ptr.data())->hasSpans() && frame_rows > 0 && frame_cols > 0) {
+            spanned.resize(frame_rows * frame_cols);
+            for (int visual_col = first_col; visual_col <= last_col; visual_col++) {
+                int logical_col = header->logicalIndex(visual_col);
+                if (header->isSectionHidden(logical_col))
+                    continue;
 
-            // исключение интервалов для span
-            int top_row = rowAt(0);
-            if (top_row >= 0) {
-                // интервалы по строкам с данными
                 for (int row = top_row; row <= bottom_row; row++) {
-                    int span = columnSpan(row, logical_col);
-                    if (span > 1)
-                        continue;
-
-                    QRect item_rect = visualRect(model()->index(row, logical_col));
-                    int bottom_pos;
-                    if (row < row_count - 1)
-                        bottom_pos = visualRect(model()->index(row + 1, logical_col)).top();
-                    else
-                        bottom_pos = item_rect.bottom();
-
-                    intervals << QPair<int, int>(item_rect.top(), bottom_pos);
+                    if (columnSpan(row, logical_col) > 1)
+                        spanned.setBit((row - top_row) * frame_cols + visual_col - first_col);
                 }
             }
+        }
 
-            for (auto i = intervals.constBegin(); i != intervals.constEnd(); ++i) {
-                if (vusual_col > first_visible_visual) {
-                    painter.setPen(Utils::pen(grid_color));
-                    painter.drawLine(left - 1, i->first, left - 1, i->second);
+        // соседние строки без объединений дают одну линию
+        QVector<QLine> lines;
+        auto add_lines = [&](int x, int visual_col) {
+            int run_top = -1;
+            int run_bottom = -1;
+            for (int i = 0; i < frame_rows; i++) {
+                if (!spanned.isEmpty() && spanned.testBit(i * frame_cols + visual_col - first_col)) {
+                    if (run_top >= 0)
+                        lines << QLine(x, run_top, x, run_bottom);
+                    run_top = -1;
+                    continue;
                 }
 
-                if (vusual_col < last_visible_visual
-                    || (!header->stretchLastSection() && vusual_col <= last_visible_visual)) {
-                    int size = header->sectionSize(logical_col);
-                    painter.setPen(Utils::pen(grid_color));
-                    painter.drawLine(left + size - 1, i->first, left + size - 1, i->second);
-                }
+                if (run_top < 0)
+                    run_top = row_bounds.at(i).first;
+                run_bottom = row_bounds.at(i).second;
             }
+            if (run_top >= 0)
+                lines << QLine(x, run_top, x, run_bottom);
+
+            if (free_top >= 0)
+                lines << QLine(x, free_top, x, viewport()->rect().bottom());
+        };
+
+        for (int visual_col = first_col; visual_col <= last_col; visual_col++) {
+            int logical_col = header->logicalIndex(visual_col);
+
+            if (header->isSectionHidden(logical_col))
+                continue;
+
+            int left = header->sectionViewportPosition(logical_col);
+
+            if (visual_col > first_visible_visual)
+                add_lines(left - 1, visual_col);
+
+            if (visual_col < last_visible_visual || !header->stretchLastSection())
+                add_lines(left + header->sectionSize(logical_col) - 1, visual_col);
+        }
+
+        if (!lines.isEmpty()) {
+            painter.setPen(Utils::pen(grid_color));
+            painter.drawLines(lines);
         }
         painter.restore();
     }
@@ -553,20 +657,31 @@ bool TableViewBase::viewportEvent(QEvent* event)
         case QEvent::HoverEnter:
         case QEvent::HoverLeave:
         case QEvent::HoverMove: {
-            // обновления ячеек при переходе с одной на другую
+            if (!_hover_tracking)
+                break;
+
+            // обновления ячеек только при переходе с одной на другую или при наведении на чекбокс внутри ячейки
             QHoverEvent* e = static_cast<QHoverEvent*>(event);
-            QModelIndex index = indexAt(e->pos());
+            QModelIndex index = event->type() == QEvent::HoverLeave ? QModelIndex() : indexAt(e->pos());
+
+            bool hover_check = false;
+            if (index.isValid()) {
+                if (auto d = qobject_cast<ItemDelegate*>(itemDelegate()))
+                    hover_check = d->checkBoxRect(index, false).contains(e->pos());
+            }
 
             if (index != _hover_index) {
-                if (_hover_index.isValid()) {
+                if (_hover_index.isValid())
                     update(_hover_index);
-                }
+                if (index.isValid())
+                    update(index);
 
                 _hover_index = index;
-            }
 
-            if (index.isValid())
+            } else if (hover_check != _hover_check && index.isValid()) {
                 update(index);
+            }
+            _hover_check = hover_check;
 
             break;
         }
@@ -591,8 +706,25 @@ void TableViewBase::dataChanged(const QModelIndex& topLeft, const QModelIndex& b
 {
     QTableView::dataChanged(topLeft, bottomRight, roles);
 
+    if (!isRowMetricsOwner() || !topLeft.isValid() || !bottomRight.isValid() || topLeft.parent() != rootIndex())
+        return;
+
+    // роли, которые не влияют на размер ячейки
+    bool size_changed = roles.isEmpty();
+    for (int role : roles) {
+        if (role != Qt::BackgroundRole && role != Qt::ForegroundRole && role != Qt::ToolTipRole && role != Qt::StatusTipRole
+            && role != Qt::WhatsThisRole) {
+            size_changed = true;
+            break;
+        }
+    }
+    if (!size_changed)
+        return;
+
+    _row_metrics->invalidateCells(topLeft.row(), bottomRight.row(), topLeft.column(), bottomRight.column());
+
     if (isAutoResizeRowsHeight())
-        requestResizeRowsToContents();
+        startResizeRows();
 }
 
 void TableViewBase::sl_columnsDragging(int from_begin, int from_end, int to, int to_hidden, bool left, bool allow)
@@ -616,6 +748,12 @@ void TableViewBase::sl_afterLoadDataFromRootHeader()
     if (_saved_index.isValid())
         setCurrentIndex(_saved_index);
     _reloading--;
+
+    // могла измениться видимость колонок
+    if (isRowMetricsOwner() && isAutoResizeRowsHeight()) {
+        _row_metrics->invalidateRows();
+        startResizeRows();
+    }
 }
 
 void TableViewBase::sl_columnResized(int column, int oldWidth, int newWidth)
@@ -627,11 +765,14 @@ void TableViewBase::rowsInserted(const QModelIndex& parent, int first, int last)
 {
     QTableView::rowsInserted(parent, first, last);
 
+    if (isRowMetricsOwner() && parent == rootIndex())
+        _row_metrics->insertRows(first, last);
+
     if (isAutoShrink())
         updateGeometry();
 
     if (isAutoResizeRowsHeight())
-        requestResizeRowsToContents();
+        startResizeRows();
 }
 
 int TableViewBase::leftPanelWidth() const
@@ -641,19 +782,88 @@ int TableViewBase::leftPanelWidth() const
 
 void TableViewBase::sl_rowsRemoved(const QModelIndex& parent, int first, int last)
 {
-    Q_UNUSED(parent)
-    Q_UNUSED(first)
-    Q_UNUSED(last)
+    if (isRowMetricsOwner() && parent == rootIndex())
+        _row_metrics->removeRows(first, last);
 
     if (isAutoShrink())
         updateGeometry();
 
-    requestResizeRowsToContents();
+    startResizeRows();
+}
+
+void TableViewBase::sl_rowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row)
+{
+    if (!isRowMetricsOwner())
+        return;
+
+    // размеры секций перемещаются вместе со строками, поэтому кэш перемещается так же
+    if (parent == rootIndex() && destination == rootIndex()) {
+        _row_metrics->moveRows(start, end, row);
+
+    } else if (parent == rootIndex()) {
+        _row_metrics->removeRows(start, end);
+        startResizeRows();
+
+    } else if (destination == rootIndex()) {
+        _row_metrics->insertRows(row, row + end - start);
+        startResizeRows();
+    }
+}
+
+void TableViewBase::sl_layoutAboutToBeChanged()
+{
+    _layout_rows.clear();
+    if (!isRowMetricsOwner() || _row_metrics->rowCount() != model()->rowCount(rootIndex()))
+        return;
+
+    // запоминаем строки, чтобы после изменения перенести кэш вслед за ними (аналогично QHeaderView)
+    _layout_rows.reserve(_row_metrics->rowCount());
+    for (int row = 0; row < _row_metrics->rowCount(); row++) {
+        _layout_rows << QPersistentModelIndex(model()->index(row, 0, rootIndex()));
+    }
+}
+
+void TableViewBase::sl_layoutChanged()
+{
+    if (!isRowMetricsOwner())
+        return;
+
+    const int row_count = model()->rowCount(rootIndex());
+    const int column_count = model()->columnCount(rootIndex());
+
+    if (column_count != _row_metrics->columnCount() || _layout_rows.count() != _row_metrics->rowCount()) {
+        _row_metrics->reset(row_count, column_count);
+
+    } else {
+        QVector<int> new_rows(_layout_rows.count(), -1);
+        for (int i = 0; i < _layout_rows.count(); i++) {
+            const QPersistentModelIndex& index = _layout_rows.at(i);
+            if (index.isValid() && index.parent() == rootIndex())
+                new_rows[i] = index.row();
+        }
+        _row_metrics->remapRows(new_rows, row_count);
+    }
+    _layout_rows.clear();
+
+    startResizeRows();
+}
+
+void TableViewBase::sl_columnsChanged()
+{
+    if (!isRowMetricsOwner())
+        return;
+
+    _row_metrics->reset(model()->rowCount(rootIndex()), model()->columnCount(rootIndex()));
+    startResizeRows();
 }
 
 void TableViewBase::sl_modelReset()
 {
-    requestResizeRowsToContents();
+    if (!isRowMetricsOwner())
+        return;
+
+    _row_metrics->reset(model()->rowCount(rootIndex()), model()->columnCount(rootIndex()));
+    startResizeRows();
 }
 
 void TableViewBase::sl_resizeToContents()
@@ -661,21 +871,43 @@ void TableViewBase::sl_resizeToContents()
     updateGeometries();
 
     bool last_need_auto = _last_need_row_auto_height;
-    bool need_auto = false;
-    if (model() != nullptr)
-        need_auto = isNeedRowsAutoHeight(model()->rowCount(), model()->columnCount()) && isAutoResizeRowsHeight();
+    bool need_auto = model() != nullptr && isAutoResizeRowsHeight();
     _last_need_row_auto_height = need_auto;
 
-    if (model() != nullptr && model()->rowCount() > 0 && (isAutoResizeRowsHeight() || last_need_auto != need_auto)) {
+    if (need_auto && !last_need_auto)
+        // высота строк могла не соответствовать содержимому
+        _row_metrics->invalidateRows();
+
+    if (model() != nullptr && model()->rowCount() > 0 && (isAutoResizeRowsHeight() || last_need_auto != need_auto)
+        && (!need_auto || _row_metrics->hasDirtyRows())) {
         emit sg_beforeResizeRowsToContent();
 
         if (need_auto) {
-            resizeRowsToContents();
+            const int row_count = model()->rowCount(rootIndex());
+            if (isMeasureAllRows(row_count, model()->columnCount(rootIndex()))) {
+                resizeDirtyRowsToContents(0, row_count - 1);
+
+            } else {
+                // сразу подгоняем строки видимой области и по странице над и под ней, остальные строки сохраняют оценочную высоту
+                // (высота по умолчанию или последняя рассчитанная) и уточняются в фоне
+                int first = rowAt(0);
+                if (first < 0)
+                    first = 0;
+                int last = rowAt(viewport()->height());
+                if (last < 0)
+                    last = row_count - 1;
+                const int page = last - first + 1;
+
+                resizeDirtyRowsToContents(qMax(0, first - page), qMin(row_count - 1, last + page));
+
+                if (_row_metrics->hasDirtyRows()) {
+                    applyEstimatedRowHeights();
+                    _refine_timer->start();
+                }
+            }
         } else {
             verticalHeader()->resizeSections(QHeaderView::Fixed);
-            for (int i = 0; i < verticalHeader()->count(); i++) {
-                verticalHeader()->resizeSection(i, verticalHeader()->defaultSectionSize());
-            }
+            verticalHeader()->resetSectionsSize();
         }
         updateGeometry();
 
@@ -683,10 +915,244 @@ void TableViewBase::sl_resizeToContents()
     }
 }
 
+QBitArray TableViewBase::measuredColumns() const
+{
+    HeaderView* header = horizontalHeader();
+    const int count = header->count();
+
+    // как и QTableView::sizeHintForRow, рассчитываем только колонки в области просмотра. Если она еще не известна, то все
+    int first = header->visualIndexAt(0);
+    int last = viewport()->width() > 0 ? header->visualIndexAt(viewport()->width() - 1) : -1;
+    if (first < 0 || count == 0)
+        return QBitArray();
+    if (last < 0)
+        last = count - 1;
+
+    QBitArray columns(count);
+    for (int visual = first; visual <= last; visual++) {
+        columns.setBit(header->logicalIndex(visual));
+    }
+    // фиксированные колонки видны всегда
+    const int frozen = qMin(count, frozenSectionCount(false));
+    for (int visual = 0; visual < frozen; visual++) {
+        columns.setBit(header->logicalIndex(visual));
+    }
+
+    return columns;
+}
+
+int TableViewBase::measureRowHeight(int row, const QBitArray& columns)
+{
+    QStyleOptionViewItem option = viewOptions();
+    HeaderView* header = horizontalHeader();
+
+    int hint = 0;
+    for (int column = 0; column < _row_metrics->columnCount(); column++) {
+        if (header->isSectionHidden(column))
+            continue;
+
+        int height = _row_metrics->cellHeight(row, column);
+        if (height < 0) {
+            if (!columns.isEmpty() && (column >= columns.size() || !columns.testBit(column))) {
+                // рассчитаем, когда колонка попадет в видимую область
+                _row_metrics->setColumnSkipped(column, true);
+                continue;
+            }
+
+            height = cellHeightHint(row, column, option);
+            _row_metrics->setCellHeight(row, column, height);
+        }
+        hint = qMax(hint, height);
+    }
+
+    return showGrid() ? hint + 1 : hint;
+}
+
+void TableViewBase::checkSkippedColumns()
+{
+    if (!isRowMetricsOwner() || model() == nullptr || !isAutoResizeRowsHeight())
+        return;
+
+    QBitArray columns = measuredColumns();
+    bool found = false;
+    for (int column = 0; column < _row_metrics->columnCount(); column++) {
+        if (!_row_metrics->isColumnSkipped(column) || (!columns.isEmpty() && (column >= columns.size() || !columns.testBit(column))))
+            continue;
+
+        _row_metrics->setColumnSkipped(column, false);
+        found = true;
+    }
+
+    if (found) {
+        // рассчитанные ячейки остаются в кэше, поэтому пересчитываются только пропущенные
+        _row_metrics->invalidateRows();
+        startResizeRows();
+    }
+}
+
+void TableViewBase::resizeVisibleRowsToContents()
+{
+    if (!isRowMetricsOwner() || model() == nullptr || !isAutoResizeRowsHeight() || !_row_metrics->hasDirtyRows())
+        return;
+
+    const int row_count = model()->rowCount(rootIndex());
+    if (row_count == 0)
+        return;
+
+    int first = rowAt(0);
+    if (first < 0)
+        first = 0;
+    int last = rowAt(viewport()->height());
+    if (last < 0)
+        last = row_count - 1;
+
+    resizeDirtyRowsToContents(first, last);
+}
+
+int TableViewBase::resizeDirtyRowsToContents(int first, int last, int time_limit)
+{
+    const int row_count = model()->rowCount(rootIndex());
+    if (_row_metrics->rowCount() != row_count || _row_metrics->columnCount() != model()->columnCount(rootIndex()))
+        _row_metrics->reset(row_count, model()->columnCount(rootIndex()));
+
+    QElapsedTimer timer;
+    if (time_limit >= 0)
+        timer.start();
+
+    const QBitArray columns = measuredColumns();
+    HeaderView* header = verticalHeader();
+    // heights[i] - новая высота строки first + i, -1 - не изменилась
+    first = qMax(0, first);
+    QVector<int> heights;
+    int stopped = -1;
+    for (int row = first; row <= qMin(last, row_count - 1); row++) {
+        if (!_row_metrics->isRowDirty(row)) {
+            heights << -1;
+            continue;
+        }
+
+        int height = qMax(measureRowHeight(row, columns), header->sectionSizeHint(row));
+        height = qBound(header->minimumSectionSize(), height, header->maximumSectionSize());
+        _row_metrics->setRowHeight(row, height);
+
+        heights << (header->isSectionHidden(row) || header->sectionSize(row) != height ? height : -1);
+
+        if (time_limit >= 0 && timer.elapsed() >= time_limit) {
+            stopped = row + 1;
+            break;
+        }
+    }
+
+    applyRowHeights(first, heights);
+    return stopped;
+}
+
+void TableViewBase::applyRowHeights(int first, const QVector<int>& heights)
+{
+    int changed = 0;
+    while (changed < heights.count() && heights.at(changed) < 0) {
+        changed++;
+    }
+    if (changed == heights.count())
+        return;
+
+    // якорь - первая видимая строка. Если изменилась высота строк над ней, то надо сдвинуть скролбар, иначе содержимое "прыгает"
+    int anchor = verticalScrollMode() == ScrollPerPixel && verticalScrollBar()->value() > 0 ? rowAt(0) : -1;
+    int anchor_pos = anchor >= 0 ? rowViewportPosition(anchor) : 0;
+
+    verticalHeader()->setSectionsSize(first, heights);
+
+    if (anchor >= 0 && first + changed < anchor) {
+        updateGeometries();
+        int shift = rowViewportPosition(anchor) - anchor_pos;
+        if (shift != 0)
+            verticalScrollBar()->setValue(verticalScrollBar()->value() + shift);
+    }
+}
+
+void TableViewBase::applyEstimatedRowHeights()
+{
+    HeaderView* header = verticalHeader();
+    int estimate = _row_metrics->averageRowHeight();
+    if (estimate < 0)
+        return;
+    estimate = qBound(header->minimumSectionSize(), estimate, header->maximumSectionSize());
+
+    // оценка задается один раз, далее строка ждет фонового уточнения
+    QVector<int> heights(_row_metrics->rowCount(), -1);
+    for (int row = 0; row < _row_metrics->rowCount(); row++) {
+        if (_row_metrics->rowHeight(row) >= 0 || _row_metrics->isRowEstimated(row))
+            continue;
+
+        _row_metrics->setRowEstimated(row);
+        if (header->sectionSize(row) != estimate)
+            heights[row] = estimate;
+    }
+
+    applyRowHeights(0, heights);
+}
+
+void TableViewBase::sl_refineRowsHeight()
+{
+    if (model() == nullptr || !isAutoResizeRowsHeight() || !_row_metrics->hasDirtyRows())
+        return;
+
+    const int row_count = model()->rowCount(rootIndex());
+    if (_refine_row >= row_count)
+        _refine_row = 0;
+
+    int stopped = resizeDirtyRowsToContents(_refine_row, row_count - 1, _refine_rows_time_limit);
+    // строки до _refine_row могли стать "грязными" за время уточнения, поэтому по окончании идем по кругу
+    _refine_row = stopped < 0 ? 0 : stopped;
+
+    if (_row_metrics->hasDirtyRows())
+        _refine_timer->start();
+    else
+        updateGeometry();
+}
+
+int TableViewBase::cellHeightHint(int row, int column, QStyleOptionViewItem& option) const
+{
+    QModelIndex index = model()->index(row, column, rootIndex());
+
+    int hint = 0;
+    QWidget* editor = indexWidget(index);
+    if (editor != nullptr)
+        hint = editor->sizeHint().height();
+
+    option.rect.setY(rowViewportPosition(row));
+    option.rect.setHeight(rowHeight(row));
+    option.rect.setX(columnViewportPosition(column));
+    option.rect.setWidth(columnWidth(column));
+    if (wordWrap())
+        option.features |= QStyleOptionViewItem::WrapText;
+
+    QAbstractItemDelegate* delegate =
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+        itemDelegateForIndex(index);
+#else
+        itemDelegate(index);
+#endif
+    return qMax(hint, delegate->sizeHint(option, index).height());
+}
+
+void TableViewBase::startResizeRows()
+{
+    if (isRowMetricsOwner())
+        _resize_timer->start();
+}
+
+bool TableViewBase::isRowMetricsOwner() const
+{
+    return true;
+}
+
 void TableViewBase::init()
 {
     _geometry_recursion_block = true; // чтобы исключить загадочные глюки
 
+    _row_metrics = std::make_shared<RowMetrics>();
+
     setWordWrap(true);
     // без этого не получается отследить положение мыши над viewport
     viewport()->setAttribute(Qt::WA_Hover);
@@ -731,10 +1197,27 @@ void TableViewBase::init()
     _resize_timer->setInterval(1);
     connect(_resize_timer, &QTimer::timeout, this, &TableViewBase::sl_resizeToContents);
 
+    _refine_timer = new QTimer(this);
+    _refine_timer->setSingleShot(true);
+    _refine_timer->setInterval(0);
+    connect(_refine_timer, &QTimer::timeout, this, &TableViewBase::sl_refineRowsHeight);
+
+    // размер строк изменен без генерации sectionResized
+    connect(verticalHeader(), &HeaderView::sg_sectionsResized, this, [&]() {
+        updateGeometries();
+        viewport()->update();
+    });
+
+    // при прокрутке в видимую область могут попасть строки с оценочной высотой. Подгоняются только они, остальные строки
+    // уточняются в фоне
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [&]() { resizeVisibleRowsToContents(); });
+    // при прокрутке в видимую область могут попасть колонки, ячейки которых не рассчитывались
+    connect(horizontalScrollBar(), &QScrollBar::valueChanged, this, [&]() { checkSkippedColumns(); });
+
     _geometry_recursion_block = false;
 }
 
-bool TableViewBase::isNeedRowsAutoHeight(int row_count, int column_count)
+bool TableViewBase::isMeasureAllRows(int row_count, int column_count)
 {
     return quint64(row_count) * quint64(column_count) < 5000;
 }
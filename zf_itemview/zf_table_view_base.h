@@ -5,10 +5,13 @@
 #include "zf_item_delegate.h"
 #include "zf_i_cell_column_check.h"
 
+#include <QBitArray>
+#include <QVector>
 #include <QTableView>
 
 namespace zf
 {
+class RowMetrics;
 
 //! Таблица с иерархическим заголовком, базовая для основной и фиксированной таблицы
 class ZF_ITEMVIEW_DLL_API TableViewBase : public QTableView, public I_ItemDelegateCheckInfo, public I_CellColumnCheck
@@ -57,6 +60,15 @@ public:
     virtual void setUseHtml(bool b);
     bool isUseHtml() const;
 
+    //! Кэшировать раскладку простого текста ячеек. Ускоряет перерисовку при прокрутке
+    virtual void setUseTextCache(bool b);
+    bool isUseTextCache() const;
+
+    //! Отслеживать наведение мыши на ячейки (подсветка ячейки и чекбокса под курсором). Если отключено, то перемещение
+    //! мыши не вызывает перерисовку
+    virtual void setHoverTracking(bool b);
+    bool isHoverTracking() const;
+
     void updateGeometries() override;
 
 public:
@@ -108,6 +120,9 @@ protected:
     void dataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles = QVector<int>()) override;
     void rowsInserted(const QModelIndex& parent, int first, int last) override;
 
+    //! Владеет ли представление кэшем высот строк. Если нет, то представление само высоту строк не рассчитывает
+    virtual bool isRowMetricsOwner() const;
+
     //! Ширина бокового сдвига
     virtual int leftPanelWidth() const;
     //! Высота горизонтального заголовка
@@ -150,30 +165,75 @@ private slots:
     void sl_columnResized(int column, int oldWidth, int newWidth);
 
     void sl_rowsRemoved(const QModelIndex& parent, int first, int last);
+    void sl_rowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row);
+    void sl_layoutAboutToBeChanged();
+    void sl_layoutChanged();
+    void sl_columnsChanged();
     void sl_modelReset();
 
     void sl_resizeToContents();
+    //! Фоновое уточнение высоты строк, которые находятся за пределами видимой области
+    void sl_refineRowsHeight();
 
 private:
     void init();
 
-    //! Надо ли
-    static bool isNeedRowsAutoHeight(int row_count, int column_count);
+    //! Можно ли подогнать высоту всех строк за один проход. Иначе сразу подгоняются только строки рядом с видимой областью, а
+    //! остальные уточняются в фоне
+    static bool isMeasureAllRows(int row_count, int column_count);
+
+    //! Колонки, ячейки которых рассчитываются при подгонке высоты строк (по логическому индексу): видимые в области
+    //! просмотра и фиксированные. Пустой массив, если рассчитывать надо все колонки
+    QBitArray measuredColumns() const;
+    //! Расчет высоты строки под содержимое. Пересчитываются только ячейки колонок columns, содержимое или ширина которых
+    //! изменились. Для остальных колонок используется ранее рассчитанная высота ячеек
+    int measureRowHeight(int row, const QBitArray& columns);
+    //! Если в видимую область попали колонки с нерассчитанными ячейками, то запустить пересчет высоты строк
+    void checkSkippedColumns();
+    //! Подогнать по высоте строки видимой области, требующие пересчета. Без сигналов и перестроения геометрии
+    void resizeVisibleRowsToContents();
+
+    //! Подогнать по высоте строки из диапазона, требующие пересчета. Возвращает строку, на которой расчет был прерван по
+    //! истечении time_limit (мс), или -1, если обработан весь диапазон
+    int resizeDirtyRowsToContents(int first, int last, int time_limit = -1);
+    //! Применить высоту строк first, first + 1, ... (-1 - высота не меняется). Положение видимой области не смещается при
+    //! изменении высоты строк над ней
+    void applyRowHeights(int first, const QVector<int>& heights);
+    //! Задать строкам, высота которых еще не рассчитывалась, среднюю высоту рассчитанных строк. Это позволяет сразу получить
+    //! размер полосы прокрутки, близкий к итоговому
+    void applyEstimatedRowHeights();
+    //! Расчет высоты ячейки (аналог QTableViewPrivate::heightHintForIndex)
+    int cellHeightHint(int row, int column, QStyleOptionViewItem& option) const;
+    //! Запустить пересчет высоты строк
+    void startResizeRows();
 
     QModelIndex _saved_index;
     int _reloading = 0;
 
     //! Таймер изменения ширины колонки и автовысоты строк
     QTimer* _resize_timer;
+    //! Таймер фонового уточнения высоты строк
+    QTimer* _refine_timer;
+    //! Строка, с которой продолжается фоновое уточнение высоты
+    int _refine_row = 0;
 
     // Отслеживание обновления ячеек при переходе с одной на другую
     QPersistentModelIndex _hover_index;
+    //! Курсор находится над чекбоксом ячейки _hover_index
+    bool _hover_check = false;
+    //! Отслеживать наведение мыши на ячейки
+    bool _hover_tracking = true;
 
     bool _geometry_recursion_block = false;
 
     //! Надо ли было подгонять высоту таблиц при последнем анализе
     bool _last_need_row_auto_height = false;
 
+    //! Кэш высот строк
+    std::shared_ptr<RowMetrics> _row_metrics;
+    //! Строки на момент начала изменения layout модели
+    QVector<QPersistentModelIndex> _layout_rows;
+
     friend class FrozenTableView;
 };
 
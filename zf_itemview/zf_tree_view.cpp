@@ -2,11 +2,14 @@
 #include "zf_header_view.h"
 #include "zf_item_delegate.h"
 #include "zf_utils.h"
+#include "private/zf_cell_check_store_p.h"
+#include "private/zf_tree_check_state_p.h"
 #include "private/zf_tree_view_p.h"
 #include <private/qtreeview_p.h>
 
 #include <QApplication>
 #include <QDebug>
+#include <QPainter>
 #include <QScrollBar>
 #include <QBuffer>
 
@@ -67,6 +70,12 @@ void TreeView::setModel(QAbstractItemModel* model)
         disconnect(this->model(), &QAbstractItemModel::modelReset, this, &TreeView::sl_modelReset);
     }
 
+    if (_check_source_model != nullptr)
+        disconnect(_check_source_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &TreeView::sl_sourceRowsAboutToBeRemoved);
+    _check_source_model = model != nullptr ? Utils::getTopSourceModel(model) : nullptr;
+    if (_check_source_model != nullptr)
+        connect(_check_source_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &TreeView::sl_sourceRowsAboutToBeRemoved);
+
     if (model != nullptr) {
         connect(model, &QAbstractItemModel::layoutChanged, this, &TreeView::sl_layoutChanged);
         connect(model, &QAbstractItemModel::rowsRemoved, this, &TreeView::sl_rowsRemoved);
@@ -75,8 +84,8 @@ void TreeView::setModel(QAbstractItemModel* model)
         connect(model, &QAbstractItemModel::modelReset, this, &TreeView::sl_modelReset);
     }
 
-    _checked.clear();
-    _all_checked = false;
+    _checked->clear(false);
+    _check_panel->invalidateRows();
 
     QTreeView::setModel(model);
 }
@@ -86,6 +95,130 @@ bool TreeView::isReloading() const
     return _reloading > 0;
 }
 
+void TreeView::expandIndexes(const QModelIndexList& indexes)
+{
+    if (setIndexesExpanded(indexes, true))
+        emit sg_expandedChanged();
+}
+
+void TreeView::collapseIndexes(const QModelIndexList& indexes)
+{
+    if (setIndexesExpanded(indexes, false))
+        emit sg_expandedChanged();
+}
+
+void TreeView::expandSubtree(const QModelIndex& index, int depth)
+{
+    if (model() == nullptr)
+        return;
+
+    QModelIndexList indexes;
+    if (index.isValid() && model()->hasChildren(index)) {
+        indexes << index;
+        if (depth != 0)
+            collectExpandable(index, depth < 0 ? -1 : depth - 1, indexes);
+
+    } else if (!index.isValid()) {
+        collectExpandable(rootIndex(), depth, indexes);
+    }
+
+    expandIndexes(indexes);
+}
+
+void TreeView::expandAllToDepth(int depth)
+{
+    if (model() == nullptr || depth < 0)
+        return;
+
+    QModelIndexList indexes;
+    collectExpandable(rootIndex(), depth, indexes);
+    expandIndexes(indexes);
+}
+
+void TreeView::setPrefetchDistance(int rows)
+{
+    Q_ASSERT(rows >= 0);
+    if (_prefetch_distance == rows)
+        return;
+
+    _prefetch_distance = rows;
+    requestPrefetch();
+}
+
+int TreeView::prefetchDistance() const
+{
+    return _prefetch_distance;
+}
+
+void TreeView::setFetchPlaceholderText(const QString& text)
+{
+    if (_fetch_placeholder_text == text)
+        return;
+
+    _fetch_placeholder_text = text;
+    viewport()->update();
+}
+
+QString TreeView::fetchPlaceholderText() const
+{
+    return _fetch_placeholder_text;
+}
+
+bool TreeView::setIndexesExpanded(const QModelIndexList& indexes, bool expand)
+{
+    if (model() == nullptr || indexes.isEmpty())
+        return false;
+
+    QTreeViewPrivate* d = privatePtr();
+    bool changed = false;
+
+    for (auto& index : indexes) {
+        if (!index.isValid() || index.model() != model())
+            continue;
+
+        QPersistentModelIndex persistent = index.column() == 0 ? index : index.sibling(index.row(), 0);
+        if (expand) {
+            if (d->expandedIndexes.contains(persistent) || !model()->hasChildren(persistent))
+                continue;
+
+            // аналогично QTreeView::expand
+            if (model()->canFetchMore(persistent))
+                model()->fetchMore(persistent);
+
+            d->expandedIndexes.insert(persistent);
+
+        } else {
+            if (!d->expandedIndexes.remove(persistent))
+                continue;
+        }
+
+        changed = true;
+    }
+
+    if (!changed)
+        return false;
+
+    // вместо раскладки на каждый узел - одна отложенная раскладка, после которой обновятся геометрия и панель чекбоксов
+    scheduleDelayedItemsLayout();
+    _check_panel->invalidateRows();
+    requestPrefetch();
+    return true;
+}
+
+void TreeView::collectExpandable(const QModelIndex& parent, int depth, QModelIndexList& indexes) const
+{
+    int row_count = model()->rowCount(parent);
+    for (int row = 0; row < row_count; row++) {
+        QModelIndex index = model()->index(row, 0, parent);
+        if (!model()->hasChildren(index))
+            continue;
+
+        indexes << index;
+        if (depth != 0)
+            collectExpandable(index, depth < 0 ? -1 : depth - 1, indexes);
+    }
+}
+
 void TreeView::setUseHtml(bool b)
 {
     if (auto d = qobject_cast<ItemDelegate*>(itemDelegate())) {
@@ -105,6 +238,44 @@ bool TreeView::isUseHtml() const
     return false;
 }
 
+void TreeView::setUseTextCache(bool b)
+{
+    if (auto d = qobject_cast<ItemDelegate*>(itemDelegate())) {
+        d->setUseTextCache(b);
+        update();
+    } else {
+        Q_ASSERT(false);
+    }
+}
+
+bool TreeView::isUseTextCache() const
+{
+    if (auto d = qobject_cast<ItemDelegate*>(itemDelegate()))
+        return d->isUseTextCache();
+
+    Q_ASSERT(false);
+    return false;
+}
+
+void TreeView::setHoverTracking(bool b)
+{
+    if (_hover_tracking == b)
+        return;
+
+    _hover_tracking = b;
+    viewport()->setAttribute(Qt::WA_Hover, b);
+
+    if (_hover_index.isValid())
+        update(_hover_index);
+    _hover_index = QPersistentModelIndex();
+    _hover_check = false;
+}
+
+bool TreeView::isHoverTracking() const
+{
+    return _hover_tracking;
+}
+
 Error TreeView::serialize(QIODevice* device) const
 {
     return Utils::saveHeader(device, rootHeaderItem(), 0);
@@ -180,13 +351,13 @@ void TreeView::updateGeometries()
     QAbstractItemView::updateGeometries();
 
     _check_panel->setGeometry(0, 0, left_panel_width, geometry().height());
-    _check_panel->update();
+    _check_panel->invalidateRows();
 }
 
 void TreeView::delegateGetCheckInfo(QAbstractItemView* item_view, const QModelIndex& index, bool& show, bool& checked) const
 {
     Q_UNUSED(item_view)
-    show = cellCheckColumns(indexLevel(index)).contains(index.column());
+    show = isCellCheckColumn(cellLevel(index), index.column(), false);
     if (!show) {
         checked = false;
         return;
@@ -198,6 +369,11 @@ void TreeView::paintEvent(QPaintEvent* event)
 {
     QTreeView::paintEvent(event);
 
+    if (model() != nullptr && !_fetch_placeholder_text.isEmpty()) {
+        QPainter painter(viewport());
+        paintFetchPlaceholder(&painter);
+    }
+
     // отображение куда будет вставлен перетаскиваемый заголовок
     Utils::paintHeaderDragHandle(this, horizontalHeader());
 }
@@ -281,20 +457,31 @@ bool TreeView::viewportEvent(QEvent* event)
         case QEvent::HoverEnter:
         case QEvent::HoverLeave:
         case QEvent::HoverMove: {
-            // обновления ячеек при переходе с одной на другую
+            if (!_hover_tracking)
+                break;
+
+            // обновления ячеек только при переходе с одной на другую или при наведении на чекбокс внутри ячейки
             QHoverEvent* e = static_cast<QHoverEvent*>(event);
-            QModelIndex index = indexAt(e->pos());
+            QModelIndex index = event->type() == QEvent::HoverLeave ? QModelIndex() : indexAt(e->pos());
+
+            bool hover_check = false;
+            if (index.isValid()) {
+                if (auto d = qobject_cast<ItemDelegate*>(itemDelegate()))
+                    hover_check = d->checkBoxRect(index, false).contains(e->pos());
+            }
 
             if (index != _hover_index) {
-                if (_hover_index.isValid()) {
+                if (_hover_index.isValid())
                     update(_hover_index);
-                }
+                if (index.isValid())
+                    update(index);
 
                 _hover_index = index;
-            }
 
-            if (index.isValid())
+            } else if (hover_check != _hover_check && index.isValid()) {
                 update(index);
+            }
+            _hover_check = hover_check;
 
             break;
         }
@@ -318,7 +505,7 @@ void TreeView::mousePressEvent(QMouseEvent* e)
         // было ли нажатие на чекбокс внутри ячейки
         ItemDelegate* delegate = qobject_cast<ItemDelegate*>(itemDelegate());
         if (delegate != nullptr) {
-            if (cellCheckColumns(indexLevel(idx)).value(idx.column())) {
+            if (isCellCheckColumn(indexLevel(idx), idx.column(), true)) {
                 QRect check_rect = delegate->checkBoxRect(idx, false);
                 if (check_rect.contains(e->pos())) {
                     setCellChecked(idx, !isCellChecked(idx));
@@ -348,10 +535,31 @@ void TreeView::mouseDoubleClickEvent(QMouseEvent* e)
     QTreeView::mouseDoubleClickEvent(e);
 }
 
+void TreeView::drawRow(QPainter* painter, const QStyleOptionViewItem& options, const QModelIndex& index) const
+{
+    // уровень вложенности уже рассчитан QTreeView при раскладке строк, поэтому делегату не нужно обходить родителей.
+    // QTreeView считает уровень от rootIndex, а не от корня модели
+    QTreeViewPrivate* d = privatePtr();
+    if (d->current >= 0 && d->current < d->viewItems.count() && d->viewItems.at(d->current).index == index) {
+        QModelIndex root = rootIndex();
+        int root_level = root.isValid() ? indexLevel(root) + 1 : 0;
+        _painting_row_level = static_cast<int>(d->viewItems.at(d->current).level) + root_level;
+    }
+
+    QTreeView::drawRow(painter, options, index);
+    _painting_row_level = -1;
+}
+
 void TreeView::scrollContentsBy(int dx, int dy)
 {
     QTreeView::scrollContentsBy(dx, dy);
-    _check_panel->update();
+    if (dy != 0) {
+        _check_panel->invalidateRows();
+        requestPrefetch();
+
+    } else {
+        _check_panel->update();
+    }
 }
 
 void TreeView::selectColumn(int column)
@@ -411,20 +619,19 @@ void TreeView::sl_columnResized(int column, int oldWidth, int newWidth)
 void TreeView::sl_expanded(const QModelIndex& index)
 {
     Q_UNUSED(index)
-    if (isShowCheckRowPanel())
-        _check_panel->update();
+    _check_panel->invalidateRows();
+    requestPrefetch();
 }
 
 void TreeView::sl_collapsed(const QModelIndex& index)
 {
     Q_UNUSED(index)
-    if (isShowCheckRowPanel())
-        _check_panel->update();
+    _check_panel->invalidateRows();
 }
 
 void TreeView::sl_layoutChanged()
 {
-    _check_panel->update();
+    _check_panel->invalidateRows();
 }
 
 void TreeView::sl_rowsRemoved(const QModelIndex& parent, int first, int last)
@@ -432,7 +639,13 @@ void TreeView::sl_rowsRemoved(const QModelIndex& parent, int first, int last)
     Q_UNUSED(parent);
     Q_UNUSED(first);
     Q_UNUSED(last);
-    _check_panel->update();
+    _check_panel->invalidateRows();
+}
+
+void TreeView::sl_sourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last)
+{
+    // решения хранятся для индексов source, поэтому строки, скрытые прокси моделью, сохраняют выделение
+    _checked->removeRows(_check_source_model, parent, first, last);
 }
 
 void TreeView::sl_rowsInserted(const QModelIndex& parent, int first, int last)
@@ -440,7 +653,9 @@ void TreeView::sl_rowsInserted(const QModelIndex& parent, int first, int last)
     Q_UNUSED(parent);
     Q_UNUSED(first);
     Q_UNUSED(last);
-    _check_panel->update();
+    // новые строки наследуют выделение от родителя, поэтому дозагрузка узла не требует пересчета выделения
+    _check_panel->invalidateRows();
+    requestPrefetch();
 }
 
 void TreeView::sl_rowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row)
@@ -451,14 +666,73 @@ void TreeView::sl_rowsMoved(const QModelIndex& parent, int start, int end, const
     Q_UNUSED(destination);
     Q_UNUSED(row);
 
-    _checked.clear();
-    _check_panel->update();
+    // решения хранятся в QPersistentModelIndex и перемещаются вместе со строками, но могли сменить родителя
+    _checked->rebuild();
+    _check_panel->invalidateRows();
 }
 
 void TreeView::sl_modelReset()
 {
-    _checked.clear();
-    _check_panel->update();
+    _checked->clear(false);
+    _check_panel->invalidateRows();
+}
+
+void TreeView::sl_prefetch()
+{
+    if (model() == nullptr || _prefetch_distance <= 0)
+        return;
+
+    QTreeViewPrivate* d = privatePtr();
+    // viewItems должны соответствовать модели после отложенных вставок, удалений и раскрытия узлов
+    d->executePostedLayout();
+
+    if (d->viewItems.isEmpty()) {
+        if (model()->canFetchMore(rootIndex()))
+            model()->fetchMore(rootIndex());
+        return;
+    }
+
+    int first = d->firstVisibleItem();
+    if (first < 0)
+        return;
+    int last = d->itemAtCoordinate(viewport()->height());
+    if (last < 0)
+        last = d->viewItems.count() - 1;
+    last = qMin(last + _prefetch_distance, d->viewItems.count() - 1);
+
+    /* fetchMore может синхронно вставить строки и изменить viewItems, поэтому сначала запоминаем узлы окна. Раскрытые
+     * узлы без загруженных дочерних строк помечаются отдельно */
+    QVector<QPersistentModelIndex> indexes;
+    QSet<QPersistentModelIndex> empty_expanded;
+    indexes.reserve(last - first + 1);
+    for (int i = first; i <= last; i++) {
+        const QTreeViewItem& item = d->viewItems.at(i);
+        indexes << item.index;
+        if (item.expanded && item.total == 0)
+            empty_expanded << item.index;
+    }
+
+    // каждый узел запрашивает не более одной порции за проход. Следующая будет запрошена после rowsInserted, если
+    // последняя строка узла все еще находится в окне упреждающей загрузки
+    QSet<QPersistentModelIndex> fetched;
+    for (auto& index : qAsConst(indexes)) {
+        if (!index.isValid())
+            continue;
+
+        // раскрытый узел, дочерние строки которого еще не загружены
+        if (empty_expanded.contains(index) && !fetched.contains(index) && model()->canFetchMore(index)) {
+            fetched << index;
+            model()->fetchMore(index);
+        }
+
+        // последняя загруженная строка узла
+        QModelIndex parent = index.parent();
+        if (index.row() != model()->rowCount(parent) - 1 || fetched.contains(parent) || !model()->canFetchMore(parent))
+            continue;
+
+        fetched << parent;
+        model()->fetchMore(parent);
+    }
 }
 
 QTreeViewPrivate* TreeView::privatePtr() const
@@ -468,6 +742,9 @@ QTreeViewPrivate* TreeView::privatePtr() const
 
 void TreeView::init()
 {
+    _cell_checked = new CellCheckStore(this);
+    _checked = std::make_shared<TreeCheckState>();
+
     _check_panel = new TreeCheckBoxPanel(this);
     _check_panel->setHidden(true);
 
@@ -501,6 +778,55 @@ void TreeView::init()
     _column_resize_timer->setSingleShot(true);
     _column_resize_timer->setInterval(0);
     connect(_column_resize_timer, &QTimer::timeout, this, [&]() { updateGeometries(); });
+
+    _prefetch_timer = new QTimer(this);
+    _prefetch_timer->setSingleShot(true);
+    _prefetch_timer->setInterval(0);
+    connect(_prefetch_timer, &QTimer::timeout, this, &TreeView::sl_prefetch);
+}
+
+void TreeView::requestPrefetch()
+{
+    if (_prefetch_distance > 0 && model() != nullptr && !_prefetch_timer->isActive())
+        _prefetch_timer->start();
+}
+
+void TreeView::paintFetchPlaceholder(QPainter* painter)
+{
+    QTreeViewPrivate* d = privatePtr();
+
+    // заглушка выводится в свободной области под последней строкой, чтобы не сдвигать раскладку QTreeView
+    QModelIndex parent = rootIndex();
+    int level = 0;
+    int top = 0;
+    if (!d->viewItems.isEmpty()) {
+        const QTreeViewItem& item = d->viewItems.constLast();
+        QRect rect = visualRect(item.index);
+        if (!rect.isValid() || rect.bottom() >= viewport()->height())
+            return;
+
+        top = rect.bottom() + 1;
+        // ищем ближайший узел, который может догрузить строки
+        parent = item.index.parent();
+        level = static_cast<int>(item.level);
+        while (parent != rootIndex() && !model()->canFetchMore(parent)) {
+            parent = parent.parent();
+            level--;
+        }
+    }
+
+    if (!model()->canFetchMore(parent))
+        return;
+
+    // отступ как у дочерних строк узла в колонке дерева
+    int tree_column = qMax(0, treePosition());
+    int left = header()->sectionViewportPosition(tree_column) + (rootIsDecorated() ? level + 1 : level) * indentation();
+    QRect rect(left, top, viewport()->width() - left, fontMetrics().height() + 4);
+
+    painter->save();
+    painter->setPen(palette().color(QPalette::Disabled, QPalette::Text));
+    painter->drawText(rect.adjusted(2, 0, 0, 0), Qt::AlignLeft | Qt::AlignVCenter, _fetch_placeholder_text);
+    painter->restore();
 }
 
 void TreeView::selectColumnHelper(QItemSelection& selection, int column, const QModelIndex& parent)
@@ -540,6 +866,62 @@ std::shared_ptr<QMap<int, bool>> TreeView::cellCheckColumnsHelper(int level) con
     return nullptr;
 }
 
+void TreeView::updateCellCheckColumnBits()
+{
+    _cell_check_column_bits.clear();
+    _cell_check_column_enabled_bits.clear();
+
+    if (_cell_check_columns.isEmpty())
+        return;
+
+    int level_count = _cell_check_columns.lastKey() + 2;
+    _cell_check_column_bits.resize(level_count);
+    _cell_check_column_enabled_bits.resize(level_count);
+
+    for (auto it = _cell_check_columns.constBegin(); it != _cell_check_columns.constEnd(); ++it) {
+        const QMap<int, bool>& columns = *it.value();
+        if (columns.isEmpty())
+            continue;
+
+        int size = columns.lastKey() + 1;
+        QBitArray& visible = _cell_check_column_bits[it.key() + 1];
+        QBitArray& enabled = _cell_check_column_enabled_bits[it.key() + 1];
+        visible.resize(size);
+        enabled.resize(size);
+
+        for (auto c = columns.constBegin(); c != columns.constEnd(); ++c) {
+            if (c.key() < 0)
+                continue;
+            visible.setBit(c.key());
+            enabled.setBit(c.key(), c.value());
+        }
+    }
+}
+
+bool TreeView::isCellCheckColumn(int level, int column, bool enabled_only) const
+{
+    if (column < 0 || _cell_check_column_bits.isEmpty())
+        return false;
+
+    // настройка для всех уровней имеет приоритет (аналогично cellCheckColumnsHelper)
+    int pos = _cell_check_column_bits.at(0).isEmpty() ? level + 1 : 0;
+    if (pos >= _cell_check_column_bits.count())
+        return false;
+
+    const QBitArray& bits = enabled_only ? _cell_check_column_enabled_bits.at(pos) : _cell_check_column_bits.at(pos);
+    return column < bits.size() && bits.testBit(column);
+}
+
+int TreeView::cellLevel(const QModelIndex& index) const
+{
+    if (_painting_row_level >= 0) {
+        Q_ASSERT(_painting_row_level == indexLevel(index));
+        return _painting_row_level;
+    }
+
+    return indexLevel(index);
+}
+
 QModelIndex TreeView::sourceIndex(const QModelIndex& index) const
 {
     Q_ASSERT(index.isValid());
@@ -549,6 +931,12 @@ QModelIndex TreeView::sourceIndex(const QModelIndex& index) const
     return idx;
 }
 
+QModelIndex TreeView::checkRowIndex(const QModelIndex& index) const
+{
+    QModelIndex idx = sourceIndex(index);
+    return idx.column() == 0 ? idx : idx.sibling(idx.row(), 0);
+}
+
 void TreeView::showCheckRowPanel(bool show)
 {
     if (isShowCheckRowPanel() == show)
@@ -567,83 +955,56 @@ bool TreeView::isShowCheckRowPanel() const
 
 bool TreeView::hasCheckedRows() const
 {
-    return isAllRowsChecked() || !_checked.isEmpty();
+    return _checked->hasChecked();
 }
 
 bool TreeView::isRowChecked(const QModelIndex& index) const
 {
-    if (_all_checked)
-        return true;
-
-    return _checked.contains(sourceIndex(index));
+    return _checked->isChecked(checkRowIndex(index));
 }
 
 void TreeView::checkRow(const QModelIndex& index, bool checked)
 {
-    if (isRowChecked(index) == checked)
+    if (!_checked->setChecked(checkRowIndex(index), checked))
         return;
 
-    QModelIndex source_index = sourceIndex(index);
-
-    if (checked) {
-        if (_all_checked)
-            return;
-
-        _checked << source_index;
-    } else {
-        if (_all_checked) {
-            Q_ASSERT(_checked.isEmpty());
-            QModelIndexList all_indexes;
-            Utils::getAllIndexes(Utils::getTopSourceModel(model()), all_indexes);
-
-            for (auto& idx : qAsConst(all_indexes)) {
-                if (source_index == idx)
-                    continue;
-                _checked << idx;
-            }
-            _all_checked = false;
+    _check_panel->update();
+    emit sg_checkedRowsChanged();
+}
 
-        } else {
-            _checked.remove(source_index);
-        }
-    }
+void TreeView::checkSubtree(const QModelIndex& index, bool checked)
+{
+    if (!_checked->setSubtreeChecked(checkRowIndex(index), checked))
+        return;
 
     _check_panel->update();
     emit sg_checkedRowsChanged();
 }
 
-QSet<QModelIndex> TreeView::checkedRows() const
+Qt::CheckState TreeView::rowCheckState(const QModelIndex& index) const
 {
-    QSet<QModelIndex> res;
-    if (isAllRowsChecked() && _checked.isEmpty()) {
-        QModelIndexList all_indexes;
-        Utils::getAllIndexes(model(), all_indexes);
-
-        for (auto& i : qAsConst(all_indexes)) {
-            res << Utils::getTopSourceIndex(i);
-        }
+    return _checked->checkState(checkRowIndex(index));
+}
 
-    } else {
-        for (auto& idx : qAsConst(_checked)) {
-            res << idx;
-        }
-    }
+QSet<QModelIndex> TreeView::checkedRows() const
+{
+    if (model() == nullptr)
+        return {};
 
-    return res;
+    return _checked->checkedIndexes(Utils::getTopSourceModel(model()));
 }
 
 bool TreeView::isAllRowsChecked() const
 {
-    return _all_checked;
+    return _checked->isAllChecked();
 }
 
 void TreeView::checkAllRows(bool checked)
 {
-    if (_all_checked && checked)
+    if (_checked->isAllChecked() && checked)
         return;
 
-    _checked.clear();
-    _all_checked = checked;
+    _checked->clear(checked);
 
     _check_panel->update();
     emit sg_checkedRowsChanged();
@@ -679,79 +1040,112 @@ void TreeView::setCellCheckColumn(int logical_index, bool visible, bool enabled,
             _cell_check_columns.remove(level);
     }
 
+    updateCellCheckColumnBits();
     viewport()->update();
 }
 
 bool TreeView::isCellChecked(const QModelIndex& index) const
 {
     Q_ASSERT(index.isValid());
-    QModelIndex source_index = sourceIndex(index);
-
-    for (int i = _cell_checked.count() - 1; i >= 0; i--) {
-        if (!_cell_checked.at(i).isValid()) {
-            _cell_checked.removeAt(i);
-            continue;
-        }
-
-        if (_cell_checked.at(i) == source_index)
-            return true;
-    }
-
-    return false;
+    return _cell_checked->isChecked(sourceIndex(index));
 }
 
 void TreeView::setCellChecked(const QModelIndex& index, bool checked)
 {
     Q_ASSERT(index.isValid());
     QModelIndex source_index = sourceIndex(index);
-    QModelIndex view_index = Utils::alignIndexToModel(index, model());
 
-    for (int i = _cell_checked.count() - 1; i >= 0; i--) {
-        if (!_cell_checked.at(i).isValid()) {
-            _cell_checked.removeAt(i);
-            continue;
-        }
+    if (!_cell_checked->setChecked(source_index, checked))
+        return;
 
-        if (_cell_checked.at(i) != source_index)
-            continue;
+    emit sg_checkedCellChanged(source_index, checked);
 
-        if (checked)
-            return;
+    QModelIndex view_index = Utils::alignIndexToModel(index, model());
+    if (view_index.isValid())
+        update(view_index);
+}
+
+QModelIndexList TreeView::checkedCells() const
+{
+    return _cell_checked->checkedCells();
+}
 
-        _cell_checked.removeAt(i);
-        emit sg_checkedCellChanged(source_index, false);
-        if (view_index.isValid())
-            update(view_index);
+void TreeView::clearCheckedCells()
+{
+    const QModelIndexList cells = _cell_checked->checkedCells();
+    if (cells.isEmpty())
         return;
-    }
 
-    if (checked) {
-        _cell_checked << source_index;
-        emit sg_checkedCellChanged(source_index, true);
-        if (view_index.isValid())
-            update(view_index);
+    _cell_checked->clear();
+    for (auto& c : cells) {
+        emit sg_checkedCellChanged(c, false);
     }
+
+    viewport()->update();
 }
 
-QModelIndexList TreeView::checkedCells() const
+void TreeView::setCellsChecked(const QModelIndex& top_left, const QModelIndex& bottom_right, bool checked)
 {
-    QModelIndexList res;
-    for (int i = _cell_checked.count() - 1; i >= 0; i--) {
-        if (!_cell_checked.at(i).isValid()) {
-            _cell_checked.removeAt(i);
-            continue;
-        }
+    Q_ASSERT(top_left.isValid() && bottom_right.isValid());
+    Q_ASSERT(top_left.model() == model() && bottom_right.model() == model());
+    Q_ASSERT(top_left.parent() == bottom_right.parent());
+
+    int changed = 0;
+    if (Utils::getTopSourceModel(model()) == model()) {
+        // прокси нет - диапазон совпадает с диапазоном source модели
+        changed = _cell_checked->setChecked(
+            model(), top_left.parent(), top_left.row(), bottom_right.row(), top_left.column(), bottom_right.column(), checked);
 
-        res << _cell_checked.at(i);
+    } else {
+        for (int row = top_left.row(); row <= bottom_right.row(); row++) {
+            for (int column = top_left.column(); column <= bottom_right.column(); column++) {
+                if (_cell_checked->setChecked(sourceIndex(model()->index(row, column, top_left.parent())), checked))
+                    changed++;
+            }
+        }
     }
 
-    return res;
+    if (changed == 0)
+        return;
+
+    viewport()->update();
+    emit sg_checkedCellsChanged();
 }
 
-void TreeView::clearCheckedCells()
+void TreeView::setColumnCellsChecked(int logical_index, bool checked)
 {
-    for (auto& c : qAsConst(_cell_checked)) {
-        setCellChecked(c, false);
+    if (model() == nullptr)
+        return;
+
+    int changed = 0;
+    QAbstractItemModel* source_model = Utils::getTopSourceModel(model());
+    if (source_model == model()) {
+        // прокси нет - выделяем сразу всех потомков каждого родителя
+        const int row_count = model()->rowCount();
+        if (row_count > 0)
+            changed += _cell_checked->setChecked(model(), QModelIndex(), 0, row_count - 1, logical_index, logical_index, checked);
+
+        QModelIndexList all_indexes;
+        Utils::getAllIndexes(model(), all_indexes);
+        for (auto& parent : qAsConst(all_indexes)) {
+            const int child_count = model()->rowCount(parent);
+            if (child_count > 0)
+                changed += _cell_checked->setChecked(model(), parent, 0, child_count - 1, logical_index, logical_index, checked);
+        }
+
+    } else {
+        QModelIndexList all_indexes;
+        Utils::getAllIndexes(model(), all_indexes);
+        for (auto& idx : qAsConst(all_indexes)) {
+            if (_cell_checked->setChecked(sourceIndex(idx.sibling(idx.row(), logical_index)), checked))
+                changed++;
+        }
     }
+
+    if (changed == 0)
+        return;
+
+    viewport()->update();
+    emit sg_checkedCellsChanged();
 }
 } // namespace zf
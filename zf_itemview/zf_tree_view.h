@@ -6,6 +6,8 @@
 #include "zf_i_cell_column_check.h"
 #include "zf_error.h"
 
+#include <QBitArray>
+#include <QPointer>
 #include <QTreeView>
 #include <memory>
 
@@ -15,6 +17,8 @@ namespace zf
 {
 class HeaderView;
 class TreeCheckBoxPanel;
+class CellCheckStore;
+class TreeCheckState;
 
 //! Древовидная таблица с иерархическим заголовком
 class ZF_ITEMVIEW_DLL_API TreeView : public QTreeView, public I_ItemDelegateCheckInfo, public I_CellColumnCheck
@@ -45,10 +49,41 @@ public:
     //! Находится в процессе перезагрузки данных из rootItem
     bool isReloading() const;
 
+    //! Раскрыть группу узлов (индексы модели представления) с одной перестройкой раскладки. Сигналы expanded для
+    //! отдельных узлов не генерируются, по окончании генерируется sg_expandedChanged
+    void expandIndexes(const QModelIndexList& indexes);
+    //! Свернуть группу узлов с одной перестройкой раскладки. По окончании генерируется sg_expandedChanged
+    void collapseIndexes(const QModelIndexList& indexes);
+    //! Раскрыть узел и его потомков до глубины depth относительно узла (-1 - без ограничения) с одной перестройкой
+    //! раскладки
+    void expandSubtree(const QModelIndex& index, int depth = -1);
+    //! Раскрыть все узлы до уровня вложенности depth (0 - только узлы верхнего уровня) с одной перестройкой раскладки
+    void expandAllToDepth(int depth);
+
+    //! Количество строк за пределами видимой области, при приближении к которым у раскрытых узлов запрашивается следующая
+    //! порция дочерних строк (canFetchMore/fetchMore). 0 - только при раскрытии узла и прокрутке до конца (как в QTreeView)
+    void setPrefetchDistance(int rows);
+    int prefetchDistance() const;
+    //! Текст, который отображается под последней загруженной строкой узла, пока модель может догрузить строки.
+    //! По умолчанию пустой (не отображается). Выводится только в свободной области под последней строкой дерева для
+    //! ближайшего к ней узла, который может догрузить строки: QTreeView не резервирует под заглушку место, поэтому для
+    //! недогруженных узлов в середине дерева она не выводится
+    void setFetchPlaceholderText(const QString& text);
+    QString fetchPlaceholderText() const;
+
     //! Использовать html форматирование
     void setUseHtml(bool b);
     bool isUseHtml() const;
 
+    //! Кэшировать раскладку простого текста ячеек. Ускоряет перерисовку при прокрутке
+    void setUseTextCache(bool b);
+    bool isUseTextCache() const;
+
+    //! Отслеживать наведение мыши на ячейки (подсветка ячейки и чекбокса под курсором). Если отключено, то перемещение
+    //! мыши не вызывает перерисовку
+    void setHoverTracking(bool b);
+    bool isHoverTracking() const;
+
     //! Сохранить состояние заголовков
     Error serialize(QIODevice* device) const;
     Error serialize(QByteArray& ba) const;
@@ -71,7 +106,16 @@ public: // выделение строк (панель слева от табл
     void checkRow(
         //! Если TreeView подключена к наследнику QAbstractProxyModel, то это индекс source
         const QModelIndex& index, bool checked);
-    //! Выделенные индексы. Если TreeView подключена к наследнику QAbstractProxyModel, то это индекс source
+    //! Задать выделение строки и всех ее потомков
+    void checkSubtree(
+        //! Если TreeView подключена к наследнику QAbstractProxyModel, то это индекс source
+        const QModelIndex& index, bool checked);
+    //! Состояние выделения строки с учетом потомков. Qt::PartiallyChecked, если выделение потомков отличается от строки
+    Qt::CheckState rowCheckState(
+        //! Если TreeView подключена к наследнику QAbstractProxyModel, то это индекс source
+        const QModelIndex& index) const;
+    //! Выделенные индексы. Если TreeView подключена к наследнику QAbstractProxyModel, то это индекс source.
+    //! Возвращаются только загруженные строки. Строки, догруженные через fetchMore, наследуют выделение родителя
     QSet<QModelIndex> checkedRows() const;
     //! Все строки выделены чекбоксами
     bool isAllRowsChecked() const;
@@ -99,6 +143,10 @@ public: // выделение ячеек (чекбоксы внутри ячее
     QModelIndexList checkedCells() const override;
     //! Очистить все выделение чекбоксами
     void clearCheckedCells() override;
+    //! Задать состояние чекбоксов диапазона ячеек одного родителя. Генерирует sg_checkedCellsChanged
+    void setCellsChecked(const QModelIndex& top_left, const QModelIndex& bottom_right, bool checked);
+    //! Задать состояние чекбоксов ячеек колонки на всех уровнях вложенности. Генерирует sg_checkedCellsChanged
+    void setColumnCellsChecked(int logical_index, bool checked);
 
 public:
     void updateGeometries() override;
@@ -123,6 +171,7 @@ protected:
     void mousePressEvent(QMouseEvent* e) override;
     void mouseDoubleClickEvent(QMouseEvent* e) override;
     void scrollContentsBy(int dx, int dy) override;
+    void drawRow(QPainter* painter, const QStyleOptionViewItem& options, const QModelIndex& index) const override;
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
     void initViewItemOption(QStyleOptionViewItem* option) const override;
 #endif
@@ -136,6 +185,11 @@ signals:
     void sg_checkedCellChanged(
         //! Если TableView подключена к наследнику QAbstractProxyModel, то это индекс source
         const QModelIndex& index, bool checked) override;
+    //! Изменилось выделение группы ячеек чекбоксами (setCellsChecked, setColumnCellsChecked). sg_checkedCellChanged для
+    //! каждой ячейки при этом не генерируется
+    void sg_checkedCellsChanged();
+    //! Изменилось раскрытие группы узлов (expandIndexes, collapseIndexes, expandSubtree, expandAllToDepth)
+    void sg_expandedChanged();
 
 private slots:
     //! Выделить указанную колонку
@@ -169,41 +223,82 @@ private slots:
 
     void sl_layoutChanged();
     void sl_rowsRemoved(const QModelIndex& parent, int first, int last);
+    //! Перед удалением строк source модели. Удаляются решения выделения для удаляемых строк
+    void sl_sourceRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
     void sl_rowsInserted(const QModelIndex& parent, int first, int last);
     void sl_rowsMoved(const QModelIndex& parent, int start, int end, const QModelIndex& destination, int row);
     void sl_modelReset();
 
+    //! Запрос следующей порции строк для раскрытых узлов рядом с видимой областью
+    void sl_prefetch();
+
 private:
     void init();
     void selectColumnHelper(QItemSelection& selection, int column, const QModelIndex& parent);
     //! Глубина вложенности индекса
     static int indexLevel(const QModelIndex& index);
+    //! Раскрыть или свернуть группу узлов напрямую через QTreeViewPrivate::expandedIndexes. Возвращает истину, если
+    //! что-то изменилось
+    bool setIndexesExpanded(const QModelIndexList& indexes, bool expand);
+    //! Собрать узлы с дочерними до глубины depth относительно parent (-1 - без ограничения)
+    void collectExpandable(const QModelIndex& parent, int depth, QModelIndexList& indexes) const;
+    //! Запустить отложенный запрос следующей порции строк
+    void requestPrefetch();
+    //! Отрисовка заглушки под последней загруженной строкой, если модель может догрузить строки
+    void paintFetchPlaceholder(QPainter* painter);
     std::shared_ptr<QMap<int, bool>> cellCheckColumnsHelper(int level) const;
+    //! Перестроить битовые маски колонок с чекбоксами по _cell_check_columns
+    void updateCellCheckColumnBits();
+    //! Есть ли чекбокс в колонке на данном уровне вложенности
+    bool isCellCheckColumn(int level, int column,
+        //! Только если пользователь может менять состояние чекбокса
+        bool enabled_only) const;
+    //! Уровень вложенности индекса. Во время отрисовки строки берется из раскладки QTreeView
+    int cellLevel(const QModelIndex& index) const;
     QModelIndex sourceIndex(const QModelIndex& index) const;
+    //! Индекс source для хранения выделения строки (нулевая колонка)
+    QModelIndex checkRowIndex(const QModelIndex& index) const;
 
     QModelIndex _saved_index;
     int _reloading = 0;
 
     //! Таймер изменения ширины колонки
     QTimer* _column_resize_timer;
+    //! Таймер запроса следующей порции строк
+    QTimer* _prefetch_timer;
+    //! Количество строк за пределами видимой области для упреждающей загрузки
+    int _prefetch_distance = 0;
+    //! Текст заглушки для недогруженных узлов
+    QString _fetch_placeholder_text;
 
     //! Панель с чекбоксами
     TreeCheckBoxPanel* _check_panel;
     //! Выделенные строки. Если TreeView подключена к наследнику QAbstractProxyModel, то это индекс source
-    QSet<QPersistentModelIndex> _checked;
-    //! Все строки выделены
-    int _all_checked = false;
+    std::shared_ptr<TreeCheckState> _checked;
+    //! Source модель, к которой относятся _checked
+    QPointer<QAbstractItemModel> _check_source_model;
 
     bool _geometry_recursion_block = false;
     // Отслеживание обновления ячеек при переходе с одной на другую
     QPersistentModelIndex _hover_index;
+    //! Курсор находится над чекбоксом ячейки _hover_index
+    bool _hover_check = false;
+    //! Отслеживать наведение мыши на ячейки
+    bool _hover_tracking = true;
 
     //! Колонки, в ячейках которых, находятся чекбоксы (логические индексы колонок)
     //! Ключ - уровень вложенности (-1 для всех уровней)
     //! Значение мап: ключ - логические индексы колонок, значение - можно менять
     QMap<int, std::shared_ptr<QMap<int, bool>>> _cell_check_columns;
-    //! Состояние чекбокса ячейки. Если TableView подключена к наследнику QAbstractProxyModel, то это номер индекс source
-    mutable QList<QPersistentModelIndex> _cell_checked;
+    //! Колонки с чекбоксами в виде битовых масок по логическому индексу колонки. Индекс вектора: 0 - для всех уровней,
+    //! далее уровень вложенности + 1
+    QVector<QBitArray> _cell_check_column_bits;
+    //! Колонки с чекбоксами, которые можно менять. Индексация как у _cell_check_column_bits
+    QVector<QBitArray> _cell_check_column_enabled_bits;
+    //! Уровень вложенности (от корня модели) строки, которая сейчас отрисовывается. -1 вне drawRow
+    mutable int _painting_row_level = -1;
+    //! Состояние чекбокса ячейки. Если TreeView подключена к наследнику QAbstractProxyModel, то это индекс source
+    CellCheckStore* _cell_checked = nullptr;
 
 public:
     //! Указатель на приватные данные Qt для особых извращений
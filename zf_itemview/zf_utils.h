@@ -75,7 +75,7 @@ public:
     //! Преобразует уровень прокси индекса в уровень model. Если не может, то invalid
     static QModelIndex alignIndexToModel(const QModelIndex& index, const QAbstractItemModel* model);
 
-    //! Получить все индексы нулевой колонки для модели
+    //! Получить все индексы нулевой колонки для модели. Обходятся только загруженные строки, fetchMore не вызывается
     static void getAllIndexes(const QAbstractItemModel* m, QModelIndexList& indexes);
 
     //! Найти окно приложения